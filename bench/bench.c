@@ -0,0 +1,314 @@
+/* SPDX-License-Identifier: Zlib */
+
+/*
+ * Times the plugin's hot paths on one document of the corpus and writes the samples as JSON. Every iteration opens
+ * the document again, so the per-document caches of the plugin start out cold.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "host.h"
+#include "plugin.h"
+#include "pool.h"
+
+/* Number of pages per iteration for which the per-page operations are timed */
+#define BENCH_PAGES 10
+
+#define BENCH_ITERATIONS 5
+
+#define BENCH_SEARCH_TERM "zathura"
+
+typedef struct bench_operation_s {
+  const char* name;
+  GArray* samples; /* durations in microseconds */
+} bench_operation_t;
+
+static const char* const bench_operations[] = {
+    "pdf_document_open",
+    "pdf_document_open:read",
+    "pdf_document_open:mmap",
+    "pdf_document_pool_acquire:read",
+    "pdf_document_pool_acquire:mmap",
+    "pdf_page_init",
+    "pdf_page_render_cairo",
+    "pdf_page_search_text",
+    "pdf_page_links_get",
+    "pdf_page_get_selection",
+    "pdf_document_index_generate",
+};
+
+static gint64 bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void bench_record(GHashTable* operations, const char* name, gint64 start) {
+  const double duration        = (bench_now() - start) / 1000.0;
+  bench_operation_t* operation = g_hash_table_lookup(operations, name);
+  g_array_append_val(operation->samples, duration);
+}
+
+static void bench_index_set_free_function(girara_tree_node_t* node) {
+  girara_list_t* children = girara_node_get_children(node);
+  for (size_t n = 0; children != NULL && n < girara_list_size(children); ++n) {
+    bench_index_set_free_function(girara_list_nth(children, n));
+  }
+  girara_node_set_free_function(node, (girara_free_function_t)zathura_index_element_free);
+}
+
+/*
+ * Times opening the document and its first secondary instance (as used by worker threads) with the file read by
+ * poppler and with the shared memory mapping of ZATHURA_PDF_POPPLER_MMAP.
+ */
+static bool bench_open(const char* path, GHashTable* operations, bool mmap) {
+  char* open_name    = g_strdup_printf("pdf_document_open:%s", mmap == true ? "mmap" : "read");
+  char* acquire_name = g_strdup_printf("pdf_document_pool_acquire:%s", mmap == true ? "mmap" : "read");
+  char* previous     = g_strdup(g_getenv(PDF_MMAP_ENV));
+  g_setenv(PDF_MMAP_ENV, mmap == true ? "1" : "0", TRUE);
+
+  zathura_document_t* document = host_document_new(path);
+
+  bool ret     = false;
+  gint64 start = bench_now();
+  if (pdf_document_open(document) == ZATHURA_ERROR_OK) {
+    bench_record(operations, open_name, start);
+
+    pdf_document_t* pdf_document = zathura_document_get_data(document);
+
+    start                             = bench_now();
+    PopplerDocument* poppler_document = pdf_document_pool_acquire(pdf_document);
+    if (poppler_document != NULL) {
+      bench_record(operations, acquire_name, start);
+      pdf_document_pool_release(pdf_document, poppler_document);
+      ret = true;
+    }
+
+    pdf_document_free(document, pdf_document);
+  }
+  host_document_free(document);
+
+  if (previous != NULL) {
+    g_setenv(PDF_MMAP_ENV, previous, TRUE);
+  } else {
+    g_unsetenv(PDF_MMAP_ENV);
+  }
+  g_free(previous);
+  g_free(acquire_name);
+  g_free(open_name);
+
+  if (ret == false) {
+    fprintf(stderr, "failed to open %s %s\n", path, mmap == true ? "from a memory mapping" : "from the file");
+  }
+
+  return ret;
+}
+
+static bool bench_iteration(const char* path, GHashTable* operations) {
+  if (bench_open(path, operations, false) == false || bench_open(path, operations, true) == false) {
+    return false;
+  }
+
+  zathura_document_t* document = host_document_new(path);
+
+  gint64 start = bench_now();
+  if (pdf_document_open(document) != ZATHURA_ERROR_OK) {
+    fprintf(stderr, "failed to open %s\n", path);
+    host_document_free(document);
+    return false;
+  }
+  bench_record(operations, "pdf_document_open", start);
+
+  const unsigned int number_of_pages = zathura_document_get_number_of_pages(document);
+  host_document_create_pages(document);
+
+  /* one sample covers all pages of the document */
+  start = bench_now();
+  for (unsigned int index = 0; index < number_of_pages; ++index) {
+    pdf_page_init(zathura_document_get_page(document, index));
+  }
+  bench_record(operations, "pdf_page_init", start);
+
+  for (unsigned int index = 0; index < MIN(number_of_pages, BENCH_PAGES); ++index) {
+    zathura_page_t* page = zathura_document_get_page(document, index);
+    void* data           = zathura_page_get_data(page);
+    const double width   = zathura_page_get_width(page);
+    const double height  = zathura_page_get_height(page);
+
+    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, ceil(width), ceil(height));
+    cairo_t* cairo           = cairo_create(surface);
+    cairo_set_source_rgb(cairo, 1, 1, 1);
+    cairo_paint(cairo);
+
+    start = bench_now();
+    pdf_page_render_cairo(page, data, cairo, false);
+    bench_record(operations, "pdf_page_render_cairo", start);
+
+    cairo_destroy(cairo);
+    cairo_surface_destroy(surface);
+
+    zathura_error_t error = ZATHURA_ERROR_OK;
+
+    start                  = bench_now();
+    girara_list_t* results = pdf_page_search_text(page, data, BENCH_SEARCH_TERM, &error);
+    bench_record(operations, "pdf_page_search_text", start);
+    if (results != NULL) {
+      girara_list_free(results);
+    }
+
+    start                = bench_now();
+    girara_list_t* links = pdf_page_links_get(page, data, &error);
+    bench_record(operations, "pdf_page_links_get", start);
+    if (links != NULL) {
+      girara_list_free(links);
+    }
+
+    const zathura_rectangle_t rectangle = {0, 0, width, height};
+
+    start                    = bench_now();
+    girara_list_t* selection = pdf_page_get_selection(page, data, rectangle, &error);
+    bench_record(operations, "pdf_page_get_selection", start);
+    if (selection != NULL) {
+      girara_list_free(selection);
+    }
+  }
+
+  zathura_error_t error = ZATHURA_ERROR_OK;
+
+  start                    = bench_now();
+  girara_tree_node_t* root = pdf_document_index_generate(document, zathura_document_get_data(document), &error);
+  bench_record(operations, "pdf_document_index_generate", start);
+  if (root != NULL) {
+    bench_index_set_free_function(root);
+    girara_node_free(root);
+  }
+
+  for (unsigned int index = 0; index < number_of_pages; ++index) {
+    zathura_page_t* page = zathura_document_get_page(document, index);
+    pdf_page_clear(page, zathura_page_get_data(page));
+  }
+  pdf_document_free(document, zathura_document_get_data(document));
+  host_document_free(document);
+
+  return true;
+}
+
+static gint compare_double(gconstpointer a, gconstpointer b) {
+  const double lhs = *(const double*)a;
+  const double rhs = *(const double*)b;
+
+  return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+}
+
+static void bench_write_json(FILE* file, const char* name, const char* path, unsigned int iterations,
+                             GHashTable* operations) {
+  fprintf(file, "{\n  \"benchmark\": \"%s\",\n  \"file\": \"%s\",\n  \"poppler\": \"%s\",\n", name, path,
+          poppler_get_version());
+  fprintf(file, "  \"iterations\": %u,\n  \"unit\": \"us\",\n  \"results\": [", iterations);
+
+  bool first = true;
+  for (size_t n = 0; n < G_N_ELEMENTS(bench_operations); ++n) {
+    bench_operation_t* operation = g_hash_table_lookup(operations, bench_operations[n]);
+    GArray* samples              = operation->samples;
+    if (samples->len == 0) {
+      continue;
+    }
+
+    GArray* sorted = g_array_copy(samples);
+    g_array_sort(sorted, compare_double);
+
+    double sum = 0;
+    for (guint i = 0; i < samples->len; ++i) {
+      sum += g_array_index(samples, double, i);
+    }
+
+    const guint middle  = sorted->len / 2;
+    const double median = sorted->len % 2 == 1
+                              ? g_array_index(sorted, double, middle)
+                              : (g_array_index(sorted, double, middle - 1) + g_array_index(sorted, double, middle)) / 2;
+
+    fprintf(file, "%s\n    {\n      \"operation\": \"%s\",\n", first == true ? "" : ",", operation->name);
+    fprintf(file, "      \"median\": %.3f,\n      \"mean\": %.3f,\n      \"min\": %.3f,\n      \"max\": %.3f,\n",
+            median, sum / samples->len, g_array_index(sorted, double, 0),
+            g_array_index(sorted, double, sorted->len - 1));
+    fprintf(file, "      \"samples\": [");
+    for (guint i = 0; i < samples->len; ++i) {
+      fprintf(file, "%s%.3f", i == 0 ? "" : ", ", g_array_index(samples, double, i));
+    }
+    fprintf(file, "]\n    }");
+
+    g_array_unref(sorted);
+    first = false;
+  }
+
+  fprintf(file, "\n  ]\n}\n");
+}
+
+static void bench_operation_free(void* data) {
+  bench_operation_t* operation = data;
+  g_array_unref(operation->samples);
+  g_free(operation);
+}
+
+int main(int argc, char* argv[]) {
+  const char* output      = NULL;
+  unsigned int iterations = BENCH_ITERATIONS;
+
+  int argi = 1;
+  for (; argi < argc && strncmp(argv[argi], "--", 2) == 0; ++argi) {
+    if (strcmp(argv[argi], "--output") == 0 && argi + 1 < argc) {
+      output = argv[++argi];
+    } else if (strcmp(argv[argi], "--iterations") == 0 && argi + 1 < argc) {
+      iterations = MAX(1, atoi(argv[++argi]));
+    } else {
+      break;
+    }
+  }
+
+  if (argc - argi != 2) {
+    fprintf(stderr, "usage: %s [--output FILE] [--iterations N] NAME FILE\n", argv[0]);
+    return 1;
+  }
+
+  const char* name = argv[argi];
+  char* path       = g_canonicalize_filename(argv[argi + 1], NULL);
+
+  GHashTable* operations = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, bench_operation_free);
+  for (size_t n = 0; n < G_N_ELEMENTS(bench_operations); ++n) {
+    bench_operation_t* operation = g_malloc0(sizeof(bench_operation_t));
+    operation->name              = bench_operations[n];
+    operation->samples           = g_array_new(FALSE, FALSE, sizeof(double));
+    g_hash_table_insert(operations, (gpointer)operation->name, operation);
+  }
+
+  int ret = 0;
+  for (unsigned int iteration = 0; iteration < iterations; ++iteration) {
+    if (bench_iteration(path, operations) == false) {
+      ret = 1;
+      break;
+    }
+  }
+
+  if (ret == 0) {
+    bench_write_json(stdout, name, path, iterations, operations);
+    if (output != NULL) {
+      FILE* file = fopen(output, "w");
+      if (file == NULL) {
+        fprintf(stderr, "failed to write %s\n", output);
+        ret = 1;
+      } else {
+        bench_write_json(file, name, path, iterations, operations);
+        fclose(file);
+      }
+    }
+  }
+
+  g_hash_table_unref(operations);
+  g_free(path);
+
+  return ret;
+}
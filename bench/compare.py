@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Zlib
+
+"""Runs the benchmark of one corpus document and compares it against the stored baseline.
+
+A metric regresses if its median is slower than the baseline median by more
+than the threshold and the difference is larger than the noise of both runs,
+estimated as three times the scaled median absolute deviation (MAD). Once a
+document has a baseline, operations missing from it and baseline entries that
+were not measured fail as well, so that the gate cannot silently stop covering
+an operation. The baseline has to be recorded with --update on the machine that
+runs the gate; documents without any baseline are reported as skipped.
+"""
+
+import argparse
+import json
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+
+# exit code meson reports as a skipped test
+EXIT_SKIP = 77
+
+# scales the MAD to the standard deviation of normally distributed samples
+MAD_SCALE = 1.4826
+NOISE_FACTOR = 3
+
+
+def median_mad(samples):
+    median = statistics.median(samples)
+    mad = statistics.median(abs(sample - median) for sample in samples)
+    return median, MAD_SCALE * mad
+
+
+def run_benchmark(args):
+    with tempfile.TemporaryDirectory() as directory:
+        output = os.path.join(directory, args.name + ".json")
+        subprocess.run(
+            [args.bench, "--output", output, "--iterations", str(args.iterations), args.name, args.corpus],
+            check=True,
+            stdout=subprocess.DEVNULL,
+        )
+        with open(output) as file:
+            return json.load(file)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--bench", required=True, help="benchmark executable")
+    parser.add_argument("--baseline", required=True, help="baseline JSON file")
+    parser.add_argument("--name", required=True, help="name of the corpus document")
+    parser.add_argument("--corpus", required=True, help="corpus document")
+    parser.add_argument("--iterations", type=int, default=7, help="number of iterations")
+    parser.add_argument("--threshold", type=float, default=25, help="maximal slowdown in percent")
+    parser.add_argument("--update", action="store_true", help="store the results as new baseline")
+    args = parser.parse_args()
+
+    try:
+        with open(args.baseline) as file:
+            baseline = json.load(file)
+    except FileNotFoundError:
+        baseline = {}
+    benchmarks = baseline.setdefault("benchmarks", {})
+    reference = benchmarks.get(args.name)
+
+    # baselines are machine specific, without one there is nothing to compare against
+    if reference is None and not args.update:
+        print(f"no baseline of {args.name} in {args.baseline}, record one on this machine with --update")
+        return EXIT_SKIP
+
+    result = run_benchmark(args)
+
+    if args.update:
+        benchmarks[args.name] = {}
+        for entry in result["results"]:
+            median, mad = median_mad(entry["samples"])
+            benchmarks[args.name][entry["operation"]] = {"median": median, "mad": mad}
+        baseline.setdefault("poppler", {})[args.name] = result["poppler"]
+        with open(args.baseline, "w") as file:
+            json.dump(baseline, file, indent=2, sort_keys=True)
+            file.write("\n")
+        print(f"stored baseline of {args.name} in {args.baseline}")
+        return 0
+
+    baseline_poppler = baseline.get("poppler", {}).get(args.name)
+    if baseline_poppler is not None and baseline_poppler != result["poppler"]:
+        print(f"note: baseline was recorded with poppler {baseline_poppler}, running {result['poppler']}")
+
+    regressions = 0
+    missing = 0
+    for entry in result["results"]:
+        operation = entry["operation"]
+        median, mad = median_mad(entry["samples"])
+
+        stored = reference.get(operation)
+        if stored is None:
+            print(f"{args.name}/{operation}: {median:.1f} us MISSING BASELINE")
+            missing += 1
+            continue
+
+        change = (median / stored["median"] - 1) * 100 if stored["median"] > 0 else 0
+        noise = NOISE_FACTOR * max(mad, stored["mad"])
+        regressed = change > args.threshold and median - stored["median"] > noise
+
+        print(
+            f"{args.name}/{operation}: {median:.1f} us, baseline {stored['median']:.1f} us "
+            f"({change:+.1f}%){' REGRESSION' if regressed else ''}"
+        )
+        regressions += regressed
+
+    measured = {entry["operation"] for entry in result["results"]}
+    for operation in sorted(set(reference) - measured):
+        print(f"{args.name}/{operation}: in the baseline but not measured")
+        missing += 1
+
+    if missing > 0:
+        print(f"{missing} operation(s) of {args.name} do not match the baseline, record it again with --update")
+    if regressions > 0:
+        print(f"{regressions} operation(s) of {args.name} are more than {args.threshold:g}% slower than the baseline")
+
+    return 1 if missing > 0 or regressions > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
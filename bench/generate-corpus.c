@@ -0,0 +1,229 @@
+/* SPDX-License-Identifier: Zlib */
+
+/*
+ * Generates the PDF corpus of the benchmark suite. All content is derived from a fixed seed and the creation date is
+ * fixed, so the output only depends on the cairo version and the installed fonts.
+ */
+
+#include <cairo-pdf.h>
+#include <cairo.h>
+#include <glib.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PAGE_WIDTH 595
+#define PAGE_HEIGHT 842
+#define MARGIN 40
+
+#define TEXT_PAGES 100
+#define VECTOR_PAGES 20
+#define VECTOR_PATHS 4000
+#define IMAGE_PAGES 10
+#define IMAGE_SIZE 1200
+#define LARGE_PAGES 10000
+#define OUTLINE_PAGES 500
+#define OUTLINE_DEPTH 10
+#define OUTLINE_FANOUT 2
+#define OUTLINE_LINKS 60
+
+/* Every text page contains the search term of the benchmark */
+#define SEARCH_TERM "zathura"
+
+static const char* const words[] = {
+    "lorem", "ipsum",   "dolor",  "sit",   "amet",    "consectetur", "adipiscing", "elit",  "sed",
+    "do",    "tempor",  "magna",  "aliqua", "enim",   "minim",       "veniam",     "quis",  "nostrud",
+    "nisi",  "ullamco", "aliquip", "commodo", "duis", "aute",        "irure",      "dolore", "fugiat",
+};
+
+static void corpus_text_line(GRand* rand, GString* line, unsigned int n_words) {
+  g_string_truncate(line, 0);
+  for (unsigned int n = 0; n < n_words; ++n) {
+    if (n > 0) {
+      g_string_append_c(line, ' ');
+    }
+    if (g_rand_int_range(rand, 0, 50) == 0) {
+      g_string_append(line, SEARCH_TERM);
+    } else {
+      g_string_append(line, words[g_rand_int_range(rand, 0, G_N_ELEMENTS(words))]);
+    }
+  }
+}
+
+static void corpus_text(cairo_t* cairo, GRand* rand) {
+  GString* line = g_string_new(NULL);
+
+  cairo_select_font_face(cairo, "sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+  cairo_set_font_size(cairo, 9);
+
+  for (unsigned int page = 0; page < TEXT_PAGES; ++page) {
+    for (double y = MARGIN; y < PAGE_HEIGHT - MARGIN; y += 11) {
+      corpus_text_line(rand, line, 14);
+      cairo_move_to(cairo, MARGIN, y);
+      cairo_show_text(cairo, line->str);
+    }
+
+    cairo_move_to(cairo, MARGIN, PAGE_HEIGHT - MARGIN / 2);
+    cairo_show_text(cairo, SEARCH_TERM);
+    cairo_show_page(cairo);
+  }
+
+  g_string_free(line, TRUE);
+}
+
+static void corpus_vector(cairo_t* cairo, GRand* rand) {
+  for (unsigned int page = 0; page < VECTOR_PAGES; ++page) {
+    for (unsigned int n = 0; n < VECTOR_PATHS; ++n) {
+      cairo_set_source_rgba(cairo, g_rand_double(rand), g_rand_double(rand), g_rand_double(rand), 0.7);
+      cairo_move_to(cairo, g_rand_double_range(rand, 0, PAGE_WIDTH), g_rand_double_range(rand, 0, PAGE_HEIGHT));
+      cairo_curve_to(cairo, g_rand_double_range(rand, 0, PAGE_WIDTH), g_rand_double_range(rand, 0, PAGE_HEIGHT),
+                     g_rand_double_range(rand, 0, PAGE_WIDTH), g_rand_double_range(rand, 0, PAGE_HEIGHT),
+                     g_rand_double_range(rand, 0, PAGE_WIDTH), g_rand_double_range(rand, 0, PAGE_HEIGHT));
+      if (n % 4 == 0) {
+        cairo_close_path(cairo);
+        cairo_fill(cairo);
+      } else {
+        cairo_set_line_width(cairo, g_rand_double_range(rand, 0.2, 3));
+        cairo_stroke(cairo);
+      }
+    }
+    cairo_show_page(cairo);
+  }
+}
+
+static void corpus_images(cairo_t* cairo, GRand* rand) {
+  for (unsigned int page = 0; page < IMAGE_PAGES; ++page) {
+    cairo_surface_t* image = cairo_image_surface_create(CAIRO_FORMAT_RGB24, IMAGE_SIZE, IMAGE_SIZE);
+    unsigned char* data    = cairo_image_surface_get_data(image);
+    const int stride       = cairo_image_surface_get_stride(image);
+
+    /* smooth gradients with a little noise, similar to scanned photographs */
+    const double phase = g_rand_double_range(rand, 0, 2 * G_PI);
+    for (int y = 0; y < IMAGE_SIZE; ++y) {
+      guint32* row = (guint32*)(data + (gsize)y * stride);
+      for (int x = 0; x < IMAGE_SIZE; ++x) {
+        const guint32 noise = g_rand_int_range(rand, 0, 16);
+        const guint32 r     = 127 + 120 * sin(phase + x / 97.0) + noise;
+        const guint32 g     = 127 + 120 * cos(phase + y / 131.0) + noise;
+        const guint32 b     = 127 + 120 * sin(phase + (x + y) / 173.0) + noise;
+        row[x]              = (MIN(r, 255) << 16) | (MIN(g, 255) << 8) | MIN(b, 255);
+      }
+    }
+    cairo_surface_mark_dirty(image);
+
+    cairo_save(cairo);
+    cairo_translate(cairo, MARGIN, MARGIN);
+    cairo_scale(cairo, (double)(PAGE_WIDTH - 2 * MARGIN) / IMAGE_SIZE, (double)(PAGE_WIDTH - 2 * MARGIN) / IMAGE_SIZE);
+    cairo_set_source_surface(cairo, image, 0, 0);
+    cairo_paint(cairo);
+    cairo_restore(cairo);
+
+    cairo_surface_destroy(image);
+    cairo_show_page(cairo);
+  }
+}
+
+static void corpus_large(cairo_t* cairo) {
+  cairo_select_font_face(cairo, "sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+  cairo_set_font_size(cairo, 12);
+
+  for (unsigned int page = 0; page < LARGE_PAGES; ++page) {
+    char text[64];
+    snprintf(text, sizeof(text), "Page %u of " SEARCH_TERM, page + 1);
+    cairo_move_to(cairo, MARGIN, MARGIN);
+    cairo_show_text(cairo, text);
+
+    char attributes[64];
+    snprintf(attributes, sizeof(attributes), "page=%u", (page + 1) % LARGE_PAGES + 1);
+    cairo_tag_begin(cairo, CAIRO_TAG_LINK, attributes);
+    cairo_move_to(cairo, MARGIN, 2 * MARGIN);
+    cairo_show_text(cairo, "next page");
+    cairo_tag_end(cairo, CAIRO_TAG_LINK);
+
+    cairo_show_page(cairo);
+  }
+}
+
+static unsigned int corpus_outline_add(cairo_surface_t* surface, int parent, unsigned int depth, unsigned int page,
+                                       const char* prefix) {
+  for (unsigned int n = 0; n < OUTLINE_FANOUT; ++n) {
+    char title[128];
+    char attributes[64];
+    snprintf(title, sizeof(title), "%s%s%u", prefix, prefix[0] != '\0' ? "." : "", n + 1);
+    snprintf(attributes, sizeof(attributes), "page=%u", page % OUTLINE_PAGES + 1);
+
+    const int id = cairo_pdf_surface_add_outline(surface, parent, title, attributes, 0);
+    page++;
+    if (depth > 1) {
+      page = corpus_outline_add(surface, id, depth - 1, page, title);
+    }
+  }
+
+  return page;
+}
+
+static void corpus_outline(cairo_t* cairo, cairo_surface_t* surface, GRand* rand) {
+  cairo_select_font_face(cairo, "sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+  cairo_set_font_size(cairo, 8);
+
+  for (unsigned int page = 0; page < OUTLINE_PAGES; ++page) {
+    for (unsigned int n = 0; n < OUTLINE_LINKS; ++n) {
+      char attributes[64];
+      if (n % 10 == 0) {
+        snprintf(attributes, sizeof(attributes), "uri='https://example.org/%u/%u'", page, n);
+      } else {
+        snprintf(attributes, sizeof(attributes), "page=%d", g_rand_int_range(rand, 1, OUTLINE_PAGES + 1));
+      }
+
+      cairo_tag_begin(cairo, CAIRO_TAG_LINK, attributes);
+      cairo_move_to(cairo, MARGIN + (n % 6) * 85, MARGIN + (n / 6) * 70);
+      cairo_show_text(cairo, "reference");
+      cairo_tag_end(cairo, CAIRO_TAG_LINK);
+    }
+    cairo_show_page(cairo);
+  }
+
+  corpus_outline_add(surface, CAIRO_PDF_OUTLINE_ROOT, OUTLINE_DEPTH, 0, "");
+}
+
+int main(int argc, char* argv[]) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s text|vector|images|large|outline OUTPUT\n", argv[0]);
+    return 1;
+  }
+
+  const char* kind = argv[1];
+
+  cairo_surface_t* surface = cairo_pdf_surface_create(argv[2], PAGE_WIDTH, PAGE_HEIGHT);
+  cairo_pdf_surface_set_metadata(surface, CAIRO_PDF_METADATA_TITLE, kind);
+  cairo_pdf_surface_set_metadata(surface, CAIRO_PDF_METADATA_CREATE_DATE, "2020-01-01T00:00:00");
+  cairo_t* cairo = cairo_create(surface);
+  GRand* rand    = g_rand_new_with_seed(0x7a617468);
+
+  int ret = 0;
+  if (strcmp(kind, "text") == 0) {
+    corpus_text(cairo, rand);
+  } else if (strcmp(kind, "vector") == 0) {
+    corpus_vector(cairo, rand);
+  } else if (strcmp(kind, "images") == 0) {
+    corpus_images(cairo, rand);
+  } else if (strcmp(kind, "large") == 0) {
+    corpus_large(cairo);
+  } else if (strcmp(kind, "outline") == 0) {
+    corpus_outline(cairo, surface, rand);
+  } else {
+    fprintf(stderr, "unknown corpus: %s\n", kind);
+    ret = 1;
+  }
+
+  g_rand_free(rand);
+  cairo_destroy(cairo);
+  cairo_surface_finish(surface);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    fprintf(stderr, "failed to write %s: %s\n", argv[2], cairo_status_to_string(cairo_surface_status(surface)));
+    ret = 1;
+  }
+  cairo_surface_destroy(surface);
+
+  return ret;
+}
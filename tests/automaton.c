@@ -0,0 +1,122 @@
+/* SPDX-License-Identifier: Zlib */
+
+#include "automaton.h"
+
+static bool collect_match(guint id, guint length, void* data) {
+  GPtrArray* matches = data;
+  g_ptr_array_add(matches, g_strdup_printf("%u:%u", id, length));
+  return true;
+}
+
+static gint compare_matches(gconstpointer a, gconstpointer b) {
+  return g_strcmp0(*(const char* const*)a, *(const char* const*)b);
+}
+
+static pdf_automaton_t* automaton_new(const char* const* patterns, guint n_patterns) {
+  pdf_automaton_t* automaton = pdf_automaton_new();
+  g_assert_nonnull(automaton);
+
+  for (guint n = 0; n < n_patterns; ++n) {
+    glong length      = 0;
+    gunichar* pattern = g_utf8_to_ucs4_fast(patterns[n], -1, &length);
+    pdf_automaton_add(automaton, pattern, length, n);
+    g_free(pattern);
+  }
+  pdf_automaton_build(automaton);
+
+  return automaton;
+}
+
+/* Feeds the text and returns the matches as "offset:id:length" in sorted order, offset being the last character */
+static char* automaton_matches(const pdf_automaton_t* automaton, const char* text) {
+  GPtrArray* result = g_ptr_array_new_with_free_func(g_free);
+  guint state       = pdf_automaton_start();
+
+  glong length       = 0;
+  gunichar* subject  = g_utf8_to_ucs4_fast(text, -1, &length);
+  GPtrArray* matches = g_ptr_array_new_with_free_func(g_free);
+  for (glong i = 0; i < length; ++i) {
+    state = pdf_automaton_next(automaton, state, subject[i]);
+
+    g_ptr_array_set_size(matches, 0);
+    g_assert_true(pdf_automaton_foreach_match(automaton, state, collect_match, matches));
+    for (guint n = 0; n < matches->len; ++n) {
+      g_ptr_array_add(result, g_strdup_printf("%ld:%s", i, (const char*)g_ptr_array_index(matches, n)));
+    }
+  }
+  g_ptr_array_unref(matches);
+  g_free(subject);
+
+  g_ptr_array_sort(result, compare_matches);
+  g_ptr_array_add(result, NULL);
+  char* joined = g_strjoinv(" ", (char**)result->pdata);
+  g_ptr_array_unref(result);
+
+  return joined;
+}
+
+static void test_automaton_overlapping(void) {
+  static const char* const patterns[] = {"he", "she", "his", "hers"};
+  pdf_automaton_t* automaton          = automaton_new(patterns, G_N_ELEMENTS(patterns));
+
+  /* "she" and "he" end at the same character, "hers" starts inside "she" */
+  char* matches = automaton_matches(automaton, "ushers");
+  g_assert_cmpstr(matches, ==, "3:0:2 3:1:3 5:3:4");
+  g_free(matches);
+
+  matches = automaton_matches(automaton, "this");
+  g_assert_cmpstr(matches, ==, "3:2:3");
+  g_free(matches);
+
+  matches = automaton_matches(automaton, "xyz");
+  g_assert_cmpstr(matches, ==, "");
+  g_free(matches);
+
+  pdf_automaton_free(automaton);
+}
+
+static void test_automaton_repeated(void) {
+  static const char* const patterns[] = {"aa", "a"};
+  pdf_automaton_t* automaton          = automaton_new(patterns, G_N_ELEMENTS(patterns));
+
+  /* every occurrence is reported, overlapping ones included */
+  char* matches = automaton_matches(automaton, "aaa");
+  g_assert_cmpstr(matches, ==, "0:1:1 1:0:2 1:1:1 2:0:2 2:1:1");
+  g_free(matches);
+
+  pdf_automaton_free(automaton);
+}
+
+static void test_automaton_failure_links(void) {
+  static const char* const patterns[] = {"abcd", "bce", "c"};
+  pdf_automaton_t* automaton          = automaton_new(patterns, G_N_ELEMENTS(patterns));
+
+  /* the mismatch after "abc" continues with "bc" instead of starting over */
+  char* matches = automaton_matches(automaton, "abce");
+  g_assert_cmpstr(matches, ==, "2:2:1 3:1:3");
+  g_free(matches);
+
+  pdf_automaton_free(automaton);
+}
+
+static void test_automaton_unicode(void) {
+  static const char* const patterns[] = {"straße", "ß"};
+  pdf_automaton_t* automaton          = automaton_new(patterns, G_N_ELEMENTS(patterns));
+
+  char* matches = automaton_matches(automaton, "die straße");
+  g_assert_cmpstr(matches, ==, "8:1:1 9:0:6");
+  g_free(matches);
+
+  pdf_automaton_free(automaton);
+}
+
+int main(int argc, char* argv[]) {
+  g_test_init(&argc, &argv, NULL);
+
+  g_test_add_func("/automaton/overlapping", test_automaton_overlapping);
+  g_test_add_func("/automaton/repeated", test_automaton_repeated);
+  g_test_add_func("/automaton/failure-links", test_automaton_failure_links);
+  g_test_add_func("/automaton/unicode", test_automaton_unicode);
+
+  return g_test_run();
+}
@@ -0,0 +1,125 @@
+/* SPDX-License-Identifier: Zlib */
+
+#include "cache.h"
+
+/* 16x16 ARGB32 surfaces take 1024 bytes, two of them fit into the budget but not three */
+#define CACHE_SURFACE_SIZE 16
+#define CACHE_BUDGET 2560
+
+static cairo_surface_t* surface_new(int size) {
+  cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, size, size);
+  g_assert_cmpint(cairo_surface_status(surface), ==, CAIRO_STATUS_SUCCESS);
+
+  return surface;
+}
+
+static void cache_insert(pdf_cache_t* cache, guint key, cairo_surface_t* surface) {
+  pdf_cache_insert(cache, &key, sizeof(key), surface);
+}
+
+/* Checks whether a key is cached with the expected surface, NULL expecting it not to be cached */
+static void cache_assert(pdf_cache_t* cache, guint key, cairo_surface_t* expected) {
+  cairo_surface_t* surface = pdf_cache_lookup(cache, &key, sizeof(key));
+  g_assert_true(surface == expected);
+
+  if (surface != NULL) {
+    cairo_surface_destroy(surface);
+  }
+}
+
+static void test_cache_disabled(void) {
+  g_assert_null(pdf_cache_new(0));
+
+  /* a disabled cache is NULL and can be used as such */
+  cairo_surface_t* surface = surface_new(CACHE_SURFACE_SIZE);
+  cache_insert(NULL, 1, surface);
+  cache_assert(NULL, 1, NULL);
+  pdf_cache_free(NULL);
+
+  cairo_surface_destroy(surface);
+}
+
+static void test_cache_reference(void) {
+  pdf_cache_t* cache = pdf_cache_new(CACHE_BUDGET);
+  g_assert_nonnull(cache);
+
+  /* the cache keeps its own reference */
+  cairo_surface_t* surface = surface_new(CACHE_SURFACE_SIZE);
+  cache_insert(cache, 1, surface);
+  cairo_surface_destroy(surface);
+  g_assert_cmpuint(cairo_surface_get_reference_count(surface), ==, 1);
+
+  const guint key         = 1;
+  cairo_surface_t* cached = pdf_cache_lookup(cache, &key, sizeof(key));
+  g_assert_true(cached == surface);
+  g_assert_cmpuint(cairo_surface_get_reference_count(cached), ==, 2);
+  cairo_surface_destroy(cached);
+
+  cache_assert(cache, 2, NULL);
+
+  pdf_cache_free(cache);
+}
+
+static void test_cache_eviction(void) {
+  pdf_cache_t* cache = pdf_cache_new(CACHE_BUDGET);
+  cairo_surface_t* surfaces[4];
+  for (guint n = 0; n < G_N_ELEMENTS(surfaces); ++n) {
+    surfaces[n] = surface_new(CACHE_SURFACE_SIZE);
+  }
+
+  cache_insert(cache, 0, surfaces[0]);
+  cache_insert(cache, 1, surfaces[1]);
+  cache_assert(cache, 0, surfaces[0]);
+  cache_assert(cache, 1, surfaces[1]);
+
+  /* the lookup makes 0 the most recently used entry, so 1 goes */
+  cache_assert(cache, 0, surfaces[0]);
+  cache_insert(cache, 2, surfaces[2]);
+  cache_assert(cache, 1, NULL);
+  cache_assert(cache, 2, surfaces[2]);
+  cache_assert(cache, 0, surfaces[0]);
+
+  /* replacing an entry releases its size instead of evicting another one */
+  cache_insert(cache, 2, surfaces[3]);
+  cache_assert(cache, 0, surfaces[0]);
+  cache_assert(cache, 2, surfaces[3]);
+
+  /* the lookups above left 0 as the least recently used entry */
+  cache_insert(cache, 1, surfaces[1]);
+  cache_assert(cache, 0, NULL);
+  cache_assert(cache, 2, surfaces[3]);
+  cache_assert(cache, 1, surfaces[1]);
+
+  pdf_cache_free(cache);
+  for (guint n = 0; n < G_N_ELEMENTS(surfaces); ++n) {
+    g_assert_cmpuint(cairo_surface_get_reference_count(surfaces[n]), ==, 1);
+    cairo_surface_destroy(surfaces[n]);
+  }
+}
+
+static void test_cache_oversized(void) {
+  pdf_cache_t* cache       = pdf_cache_new(CACHE_BUDGET);
+  cairo_surface_t* surface = surface_new(CACHE_SURFACE_SIZE);
+  cairo_surface_t* large   = surface_new(2 * CACHE_SURFACE_SIZE);
+
+  /* a surface larger than the budget is not cached and does not evict anything */
+  cache_insert(cache, 0, surface);
+  cache_insert(cache, 1, large);
+  cache_assert(cache, 1, NULL);
+  cache_assert(cache, 0, surface);
+
+  pdf_cache_free(cache);
+  cairo_surface_destroy(large);
+  cairo_surface_destroy(surface);
+}
+
+int main(int argc, char* argv[]) {
+  g_test_init(&argc, &argv, NULL);
+
+  g_test_add_func("/cache/disabled", test_cache_disabled);
+  g_test_add_func("/cache/reference", test_cache_reference);
+  g_test_add_func("/cache/eviction", test_cache_eviction);
+  g_test_add_func("/cache/oversized", test_cache_oversized);
+
+  return g_test_run();
+}
@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: Zlib */
+
+#include <cairo-pdf.h>
+#include <glib/gstdio.h>
+
+#include "fixture.h"
+#include "host.h"
+
+#define FIXTURE_MARGIN 40
+#define FIXTURE_FONT_SIZE 12
+#define FIXTURE_LINE_HEIGHT 20
+
+fixture_t* fixture_new(unsigned int n_pages, fixture_draw_func_t draw, void* data) {
+  fixture_t* fixture = g_malloc0(sizeof(fixture_t));
+
+  GError* error      = NULL;
+  fixture->directory = g_dir_make_tmp("zathura-pdf-poppler-XXXXXX", &error);
+  g_assert_no_error(error);
+  fixture->path = g_build_filename(fixture->directory, "document.pdf", NULL);
+
+  cairo_surface_t* surface = cairo_pdf_surface_create(fixture->path, FIXTURE_PAGE_WIDTH, FIXTURE_PAGE_HEIGHT);
+  cairo_t* cairo           = cairo_create(surface);
+  for (unsigned int page = 0; page < n_pages; ++page) {
+    cairo_save(cairo);
+    draw(cairo, page, data);
+    cairo_restore(cairo);
+    cairo_show_page(cairo);
+  }
+  cairo_destroy(cairo);
+  cairo_surface_finish(surface);
+  g_assert_cmpint(cairo_surface_status(surface), ==, CAIRO_STATUS_SUCCESS);
+  cairo_surface_destroy(surface);
+
+  fixture->document = host_document_new(fixture->path);
+  g_assert_cmpint(pdf_document_open(fixture->document), ==, ZATHURA_ERROR_OK);
+  fixture->pdf_document = zathura_document_get_data(fixture->document);
+  g_assert_cmpuint(zathura_document_get_number_of_pages(fixture->document), ==, n_pages);
+
+  host_document_create_pages(fixture->document);
+  for (unsigned int page = 0; page < n_pages; ++page) {
+    g_assert_cmpint(pdf_page_init(zathura_document_get_page(fixture->document, page)), ==, ZATHURA_ERROR_OK);
+  }
+
+  return fixture;
+}
+
+static void draw_text(cairo_t* cairo, unsigned int page, void* data) {
+  const char* const* pages = data;
+
+  cairo_select_font_face(cairo, "sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+  cairo_set_font_size(cairo, FIXTURE_FONT_SIZE);
+
+  char** lines = g_strsplit(pages[page], "\n", -1);
+  for (unsigned int n = 0; lines[n] != NULL; ++n) {
+    cairo_move_to(cairo, FIXTURE_MARGIN, FIXTURE_MARGIN + n * FIXTURE_LINE_HEIGHT);
+    cairo_show_text(cairo, lines[n]);
+  }
+  g_strfreev(lines);
+}
+
+fixture_t* fixture_new_text(const char* const* pages, unsigned int n_pages) {
+  return fixture_new(n_pages, draw_text, (void*)pages);
+}
+
+void fixture_free(fixture_t* fixture) {
+  const unsigned int n_pages = zathura_document_get_number_of_pages(fixture->document);
+  for (unsigned int page = 0; page < n_pages; ++page) {
+    zathura_page_t* zathura_page = zathura_document_get_page(fixture->document, page);
+    pdf_page_clear(zathura_page, zathura_page_get_data(zathura_page));
+  }
+  pdf_document_free(fixture->document, fixture->pdf_document);
+  host_document_free(fixture->document);
+
+  fixture_remove_tree(fixture->directory);
+  g_free(fixture->path);
+  g_free(fixture->directory);
+  g_free(fixture);
+}
+
+zathura_page_t* fixture_get_page(fixture_t* fixture, unsigned int index) {
+  zathura_page_t* page = zathura_document_get_page(fixture->document, index);
+  g_assert_nonnull(page);
+
+  return page;
+}
+
+void fixture_remove_tree(const char* path) {
+  GDir* dir = g_dir_open(path, 0, NULL);
+  if (dir != NULL) {
+    const char* name = NULL;
+    while ((name = g_dir_read_name(dir)) != NULL) {
+      char* child = g_build_filename(path, name, NULL);
+      if (g_file_test(child, G_FILE_TEST_IS_DIR) == TRUE && g_file_test(child, G_FILE_TEST_IS_SYMLINK) == FALSE) {
+        fixture_remove_tree(child);
+      } else {
+        g_remove(child);
+      }
+      g_free(child);
+    }
+    g_dir_close(dir);
+  }
+
+  g_rmdir(path);
+}
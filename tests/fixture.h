@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: Zlib */
+
+#ifndef FIXTURE_H
+#define FIXTURE_H
+
+#include <cairo.h>
+
+#include "plugin.h"
+
+/*
+ * Test documents are drawn with cairo into a temporary directory and opened with the plugin through the minimal host
+ * of the tools, so the tests neither need zathura nor checked-in PDF files.
+ */
+
+#define FIXTURE_PAGE_WIDTH 595
+#define FIXTURE_PAGE_HEIGHT 842
+
+/**
+ * Draws the content of a page
+ *
+ * @param cairo Cairo object of the page (top-left origin)
+ * @param page Page index
+ * @param data User data
+ */
+typedef void (*fixture_draw_func_t)(cairo_t* cairo, unsigned int page, void* data);
+
+/**
+ * Opened test document
+ */
+typedef struct fixture_s {
+  char* directory;              /**< Temporary directory holding the document */
+  char* path;                   /**< Path of the document */
+  zathura_document_t* document; /**< Host document with initialized pages */
+  pdf_document_t* pdf_document; /**< Internal document representation */
+} fixture_t;
+
+/**
+ * Draws a document and opens it with the plugin. Fails the test if the
+ * document cannot be opened.
+ *
+ * @param n_pages Number of pages
+ * @param draw Function drawing every page
+ * @param data User data passed to draw
+ * @return The test document
+ */
+fixture_t* fixture_new(unsigned int n_pages, fixture_draw_func_t draw, void* data);
+
+/**
+ * Creates a document with one page per string. Lines are separated by '\n'.
+ *
+ * @param pages Text of every page
+ * @param n_pages Number of pages
+ * @return The test document
+ */
+fixture_t* fixture_new_text(const char* const* pages, unsigned int n_pages);
+
+/**
+ * Closes a test document and removes its directory
+ *
+ * @param fixture The test document
+ */
+void fixture_free(fixture_t* fixture);
+
+/**
+ * Returns a page of a test document
+ *
+ * @param fixture The test document
+ * @param index Page index
+ * @return The page
+ */
+zathura_page_t* fixture_get_page(fixture_t* fixture, unsigned int index);
+
+/**
+ * Removes a directory and everything below it
+ *
+ * @param path Path of the directory
+ */
+void fixture_remove_tree(const char* path);
+
+#endif // FIXTURE_H
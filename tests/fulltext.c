@@ -0,0 +1,101 @@
+/* SPDX-License-Identifier: Zlib */
+
+#include "fixture.h"
+#include "fulltext.h"
+
+/* Seconds to wait for the background build of the index */
+#define FULLTEXT_TIMEOUT 30
+
+static const char* const fulltext_pages[] = {
+    "alpha bravo\ncharlie",
+    "delta echo\nfoxtrot",
+    "Bravo golf\nsupercalifragilistic",
+};
+
+/* Waits until the index is built and loaded, i.e. until it rules out a page */
+static void fulltext_wait(pdf_fulltext_t* fulltext) {
+  g_assert_nonnull(fulltext);
+
+  const gint64 deadline = g_get_monotonic_time() + FULLTEXT_TIMEOUT * G_TIME_SPAN_SECOND;
+  while (pdf_fulltext_page_may_match(fulltext, "zulu", 0) == true) {
+    g_assert_cmpint(g_get_monotonic_time(), <, deadline);
+    g_usleep(10 * 1000);
+  }
+}
+
+/* Checks the candidate pages of a query, one character per page: 'x' if the page may match, '-' if not */
+static void assert_candidates(pdf_fulltext_t* fulltext, const char* text, const char* expected) {
+  GString* candidates = g_string_new(NULL);
+  for (unsigned int page = 0; page < G_N_ELEMENTS(fulltext_pages); ++page) {
+    g_string_append_c(candidates, pdf_fulltext_page_may_match(fulltext, text, page) == true ? 'x' : '-');
+  }
+
+  g_assert_cmpstr(candidates->str, ==, expected);
+  g_string_free(candidates, TRUE);
+}
+
+static void test_fulltext_lookup(void) {
+  g_setenv(PDF_FULLTEXT_ENV, "1", TRUE);
+  fixture_t* fixture       = fixture_new_text(fulltext_pages, G_N_ELEMENTS(fulltext_pages));
+  pdf_fulltext_t* fulltext = fixture->pdf_document->fulltext;
+  fulltext_wait(fulltext);
+
+  assert_candidates(fulltext, "bravo", "x-x");
+  assert_candidates(fulltext, "BRAVO", "x-x");
+  assert_candidates(fulltext, "zulu", "---");
+
+  /* tokens may be part of a longer term */
+  assert_candidates(fulltext, "rav", "x-x");
+  assert_candidates(fulltext, "califragil", "--x");
+
+  /* every token has to be on the page, in any order and separated by anything */
+  assert_candidates(fulltext, "charlie alpha", "x--");
+  assert_candidates(fulltext, "echo-foxtrot", "-x-");
+  assert_candidates(fulltext, "alpha golf", "---");
+
+  /* tokens shorter than a trigram and queries without tokens do not rule out pages */
+  assert_candidates(fulltext, "ch", "xxx");
+  assert_candidates(fulltext, "bravo ch", "x-x");
+  assert_candidates(fulltext, "--", "xxx");
+
+  /* pages the index does not know about are never ruled out */
+  g_assert_true(pdf_fulltext_page_may_match(fulltext, "zulu", G_N_ELEMENTS(fulltext_pages)));
+  g_assert_true(pdf_fulltext_page_may_match(fulltext, NULL, 0));
+
+  fixture_free(fixture);
+}
+
+static void test_fulltext_persistent(void) {
+  g_setenv(PDF_FULLTEXT_ENV, "1", TRUE);
+  fixture_t* fixture = fixture_new_text(fulltext_pages, G_N_ELEMENTS(fulltext_pages));
+  fulltext_wait(fixture->pdf_document->fulltext);
+
+  /* a second open of the same file loads the written index right away */
+  pdf_fulltext_t* fulltext = pdf_fulltext_open(fixture->pdf_document);
+  g_assert_nonnull(fulltext);
+  assert_candidates(fulltext, "delta", "-x-");
+  pdf_fulltext_free(fulltext);
+
+  fixture_free(fixture);
+}
+
+static void test_fulltext_disabled(void) {
+  g_setenv(PDF_FULLTEXT_ENV, "0", TRUE);
+  fixture_t* fixture = fixture_new_text(fulltext_pages, G_N_ELEMENTS(fulltext_pages));
+
+  g_assert_null(fixture->pdf_document->fulltext);
+  assert_candidates(NULL, "zulu", "xxx");
+
+  fixture_free(fixture);
+}
+
+int main(int argc, char* argv[]) {
+  /* every test gets its own empty cache directory for the index */
+  g_test_init(&argc, &argv, G_TEST_OPTION_ISOLATE_DIRS, NULL);
+
+  g_test_add_func("/fulltext/lookup", test_fulltext_lookup);
+  g_test_add_func("/fulltext/persistent", test_fulltext_persistent);
+  g_test_add_func("/fulltext/disabled", test_fulltext_disabled);
+
+  return g_test_run();
+}
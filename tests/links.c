@@ -0,0 +1,177 @@
+/* SPDX-License-Identifier: Zlib */
+
+#include <string.h>
+
+#include "fixture.h"
+
+/* A grid of small links spread over the page plus one link spanning its whole width */
+#define LINKS_COLUMNS 5
+#define LINKS_ROWS 4
+#define LINKS_WIDTH 40
+#define LINKS_HEIGHT 20
+#define LINKS_X(column) (50 + (column) * 100)
+#define LINKS_Y(row) (50 + (row) * 150)
+#define LINKS_WIDE_Y 800
+
+static void draw_links(cairo_t* cairo, unsigned int page, void* data) {
+  (void)data;
+
+  /* the second page has no links */
+  if (page != 0) {
+    return;
+  }
+
+  for (unsigned int row = 0; row < LINKS_ROWS; ++row) {
+    for (unsigned int column = 0; column < LINKS_COLUMNS; ++column) {
+      char* attributes = g_strdup_printf("rect=[%d %d %d %d] uri='https://example.org/%u-%u'", LINKS_X(column),
+                                         LINKS_Y(row), LINKS_WIDTH, LINKS_HEIGHT, row, column);
+      cairo_tag_begin(cairo, CAIRO_TAG_LINK, attributes);
+      cairo_tag_end(cairo, CAIRO_TAG_LINK);
+      g_free(attributes);
+    }
+  }
+
+  char* attributes = g_strdup_printf("rect=[0 %d %d %d] uri='https://example.org/wide'", LINKS_WIDE_Y,
+                                     FIXTURE_PAGE_WIDTH, LINKS_HEIGHT);
+  cairo_tag_begin(cairo, CAIRO_TAG_LINK, attributes);
+  cairo_tag_end(cairo, CAIRO_TAG_LINK);
+  g_free(attributes);
+}
+
+static gint compare_uris(gconstpointer a, gconstpointer b) {
+  return g_strcmp0(*(const char* const*)a, *(const char* const*)b);
+}
+
+/* Returns the sorted URIs of a list of links separated by spaces and frees the list */
+static char* links_uris(girara_list_t* links) {
+  g_assert_nonnull(links);
+
+  GPtrArray* uris = g_ptr_array_new_with_free_func(g_free);
+  for (size_t n = 0; n < girara_list_size(links); ++n) {
+    zathura_link_t* link = girara_list_nth(links, n);
+    g_assert_cmpint(zathura_link_get_type(link), ==, ZATHURA_LINK_URI);
+
+    const zathura_link_target_t target = zathura_link_get_target(link);
+    g_assert_true(g_str_has_prefix(target.value, "https://example.org/"));
+    g_ptr_array_add(uris, g_strdup(target.value + strlen("https://example.org/")));
+  }
+  girara_list_free(links);
+
+  g_ptr_array_sort(uris, compare_uris);
+  g_ptr_array_add(uris, NULL);
+  char* joined = g_strjoinv(" ", (char**)uris->pdata);
+  g_ptr_array_unref(uris);
+
+  return joined;
+}
+
+static char* links_at(fixture_t* fixture, double x1, double y1, double x2, double y2) {
+  zathura_page_t* page           = fixture_get_page(fixture, 0);
+  const zathura_rectangle_t area = {.x1 = x1, .y1 = y1, .x2 = x2, .y2 = y2};
+  zathura_error_t error          = ZATHURA_ERROR_OK;
+
+  girara_list_t* links = pdf_page_links_get_at(page, zathura_page_get_data(page), area, &error);
+  g_assert_cmpint(error, ==, ZATHURA_ERROR_OK);
+
+  return links_uris(links);
+}
+
+static void assert_links_at(fixture_t* fixture, double x1, double y1, double x2, double y2, const char* expected) {
+  char* uris = links_at(fixture, x1, y1, x2, y2);
+  g_assert_cmpstr(uris, ==, expected);
+  g_free(uris);
+}
+
+static void test_links_all(void) {
+  fixture_t* fixture   = fixture_new(2, draw_links, NULL);
+  zathura_page_t* page = fixture_get_page(fixture, 0);
+
+  zathura_error_t error = ZATHURA_ERROR_OK;
+  girara_list_t* links  = pdf_page_links_get(page, zathura_page_get_data(page), &error);
+  g_assert_cmpint(error, ==, ZATHURA_ERROR_OK);
+  g_assert_nonnull(links);
+  g_assert_cmpuint(girara_list_size(links), ==, LINKS_ROWS * LINKS_COLUMNS + 1);
+
+  /* positions use a top-left origin like the drawing */
+  for (size_t n = 0; n < girara_list_size(links); ++n) {
+    zathura_link_t* link               = girara_list_nth(links, n);
+    const zathura_rectangle_t position = zathura_link_get_position(link);
+    if (g_strcmp0(zathura_link_get_target(link).value, "https://example.org/0-1") == 0) {
+      g_assert_cmpfloat_with_epsilon(position.x1, LINKS_X(1), 1);
+      g_assert_cmpfloat_with_epsilon(position.y1, LINKS_Y(0), 1);
+      g_assert_cmpfloat_with_epsilon(position.x2, LINKS_X(1) + LINKS_WIDTH, 1);
+      g_assert_cmpfloat_with_epsilon(position.y2, LINKS_Y(0) + LINKS_HEIGHT, 1);
+    }
+  }
+  girara_list_free(links);
+
+  /* without links, the full list is an error but the lookup is just empty */
+  page  = fixture_get_page(fixture, 1);
+  error = ZATHURA_ERROR_OK;
+  g_assert_null(pdf_page_links_get(page, zathura_page_get_data(page), &error));
+  g_assert_cmpint(error, ==, ZATHURA_ERROR_UNKNOWN);
+
+  const zathura_rectangle_t area = {.x2 = FIXTURE_PAGE_WIDTH, .y2 = FIXTURE_PAGE_HEIGHT};
+  links                          = pdf_page_links_get_at(page, zathura_page_get_data(page), area, &error);
+  g_assert_nonnull(links);
+  g_assert_cmpuint(girara_list_size(links), ==, 0);
+  girara_list_free(links);
+
+  fixture_free(fixture);
+}
+
+static void test_links_point(void) {
+  fixture_t* fixture = fixture_new(2, draw_links, NULL);
+
+  /* the centre of every link finds exactly that link */
+  for (unsigned int row = 0; row < LINKS_ROWS; ++row) {
+    for (unsigned int column = 0; column < LINKS_COLUMNS; ++column) {
+      const double x = LINKS_X(column) + LINKS_WIDTH / 2.0;
+      const double y = LINKS_Y(row) + LINKS_HEIGHT / 2.0;
+
+      char* expected = g_strdup_printf("%u-%u", row, column);
+      assert_links_at(fixture, x, y, x, y, expected);
+      g_free(expected);
+    }
+  }
+
+  /* points between the links find nothing */
+  assert_links_at(fixture, 20, 20, 20, 20, "");
+  assert_links_at(fixture, LINKS_X(1) - 10, LINKS_Y(1) + 10, LINKS_X(1) - 10, LINKS_Y(1) + 10, "");
+  assert_links_at(fixture, LINKS_X(2) + 20, LINKS_Y(2) + 60, LINKS_X(2) + 20, LINKS_Y(2) + 60, "");
+
+  fixture_free(fixture);
+}
+
+static void test_links_area(void) {
+  fixture_t* fixture = fixture_new(2, draw_links, NULL);
+
+  /* a row of links crosses several grid cells */
+  assert_links_at(fixture, 0, LINKS_Y(1), FIXTURE_PAGE_WIDTH, LINKS_Y(1) + LINKS_HEIGHT, "1-0 1-1 1-2 1-3 1-4");
+  assert_links_at(fixture, LINKS_X(3), 0, LINKS_X(3) + LINKS_WIDTH, FIXTURE_PAGE_HEIGHT / 2.0, "0-3 1-3 2-3");
+
+  /* the wide link lies in every cell of its row but is only returned once */
+  assert_links_at(fixture, 10, LINKS_WIDE_Y + 10, 10, LINKS_WIDE_Y + 10, "wide");
+  assert_links_at(fixture, FIXTURE_PAGE_WIDTH - 10, LINKS_WIDE_Y + 10, FIXTURE_PAGE_WIDTH - 10, LINKS_WIDE_Y + 10,
+                  "wide");
+  assert_links_at(fixture, 0, LINKS_WIDE_Y, FIXTURE_PAGE_WIDTH, FIXTURE_PAGE_HEIGHT, "wide");
+
+  /* the whole page returns every link once */
+  char* uris   = links_at(fixture, 0, 0, FIXTURE_PAGE_WIDTH, FIXTURE_PAGE_HEIGHT);
+  char** split = g_strsplit(uris, " ", -1);
+  g_assert_cmpuint(g_strv_length(split), ==, LINKS_ROWS * LINKS_COLUMNS + 1);
+  g_strfreev(split);
+  g_free(uris);
+
+  fixture_free(fixture);
+}
+
+int main(int argc, char* argv[]) {
+  g_test_init(&argc, &argv, NULL);
+
+  g_test_add_func("/links/all", test_links_all);
+  g_test_add_func("/links/point", test_links_point);
+  g_test_add_func("/links/area", test_links_area);
+
+  return g_test_run();
+}
@@ -0,0 +1,391 @@
+/* SPDX-License-Identifier: Zlib */
+
+#include "fixture.h"
+#include "pool.h"
+#include "text.h"
+
+static const char* const search_pages[] = {
+    "Hello World\n"
+    "hello-world worldwide\n"
+    "HELLO Café naïve\n"
+    "Date 2026-10-17",
+};
+
+/* Counts the matches of every term, -1 if the search failed with something else than "nothing found" */
+static int search_count(fixture_t* fixture, const pdf_search_term_t* terms, unsigned int n_terms, int* counts,
+                        zathura_error_t* error) {
+  zathura_page_t* page = fixture_get_page(fixture, 0);
+
+  for (unsigned int n = 0; n < n_terms; ++n) {
+    counts[n] = 0;
+  }
+
+  zathura_error_t ret    = ZATHURA_ERROR_OK;
+  girara_list_t* matches = pdf_page_search_terms(page, zathura_page_get_data(page), terms, n_terms, &ret);
+  if (error != NULL) {
+    *error = ret;
+  }
+  if (matches == NULL) {
+    return ret == ZATHURA_ERROR_UNKNOWN ? 0 : -1;
+  }
+
+  int total = 0;
+  for (size_t n = 0; n < girara_list_size(matches); ++n) {
+    const pdf_search_match_t* match = girara_list_nth(matches, n);
+    g_assert_cmpuint(match->term, <, n_terms);
+    g_assert_cmpfloat(match->rectangle.x1, <, match->rectangle.x2);
+    g_assert_cmpfloat(match->rectangle.y1, <, match->rectangle.y2);
+    counts[match->term]++;
+    total++;
+  }
+  girara_list_free(matches);
+
+  return total;
+}
+
+static int search_one(fixture_t* fixture, const char* text, pdf_search_flags_t flags) {
+  const pdf_search_term_t term = {.text = text, .flags = flags};
+  int count                    = 0;
+
+  return search_count(fixture, &term, 1, &count, NULL);
+}
+
+static void test_search_default(void) {
+  fixture_t* fixture = fixture_new_text(search_pages, G_N_ELEMENTS(search_pages));
+
+  g_assert_cmpint(search_one(fixture, "hello", PDF_SEARCH_DEFAULT), ==, 3);
+  g_assert_cmpint(search_one(fixture, "world", PDF_SEARCH_DEFAULT), ==, 3);
+  /* white space matches any run of white space, but not other separators */
+  g_assert_cmpint(search_one(fixture, "hello world", PDF_SEARCH_DEFAULT), ==, 1);
+  g_assert_cmpint(search_one(fixture, "zathura", PDF_SEARCH_DEFAULT), ==, 0);
+
+  fixture_free(fixture);
+}
+
+static void test_search_case_sensitive(void) {
+  fixture_t* fixture = fixture_new_text(search_pages, G_N_ELEMENTS(search_pages));
+
+  g_assert_cmpint(search_one(fixture, "hello", PDF_SEARCH_CASE_SENSITIVE), ==, 1);
+  g_assert_cmpint(search_one(fixture, "Hello", PDF_SEARCH_CASE_SENSITIVE), ==, 1);
+  g_assert_cmpint(search_one(fixture, "HELLO", PDF_SEARCH_CASE_SENSITIVE), ==, 1);
+  g_assert_cmpint(search_one(fixture, "hELLO", PDF_SEARCH_CASE_SENSITIVE), ==, 0);
+
+  fixture_free(fixture);
+}
+
+static void test_search_whole_word(void) {
+  fixture_t* fixture = fixture_new_text(search_pages, G_N_ELEMENTS(search_pages));
+
+  /* "worldwide" is not a whole word match, "hello-world" is */
+  g_assert_cmpint(search_one(fixture, "world", PDF_SEARCH_WHOLE_WORD), ==, 2);
+  g_assert_cmpint(search_one(fixture, "wide", PDF_SEARCH_WHOLE_WORD), ==, 0);
+  g_assert_cmpint(search_one(fixture, "worldwide", PDF_SEARCH_WHOLE_WORD), ==, 1);
+
+  fixture_free(fixture);
+}
+
+static void test_search_ignore_diacritics(void) {
+  fixture_t* fixture = fixture_new_text(search_pages, G_N_ELEMENTS(search_pages));
+
+  g_assert_cmpint(search_one(fixture, "cafe", PDF_SEARCH_DEFAULT), ==, 0);
+  g_assert_cmpint(search_one(fixture, "café", PDF_SEARCH_DEFAULT), ==, 1);
+  g_assert_cmpint(search_one(fixture, "cafe", PDF_SEARCH_IGNORE_DIACRITICS), ==, 1);
+  g_assert_cmpint(search_one(fixture, "naive", PDF_SEARCH_IGNORE_DIACRITICS), ==, 1);
+  g_assert_cmpint(search_one(fixture, "CAFE", PDF_SEARCH_IGNORE_DIACRITICS | PDF_SEARCH_CASE_SENSITIVE), ==, 0);
+  g_assert_cmpint(search_one(fixture, "Cafe", PDF_SEARCH_IGNORE_DIACRITICS | PDF_SEARCH_CASE_SENSITIVE), ==, 1);
+
+  fixture_free(fixture);
+}
+
+static void test_search_regex(void) {
+  fixture_t* fixture = fixture_new_text(search_pages, G_N_ELEMENTS(search_pages));
+
+  g_assert_cmpint(search_one(fixture, "[0-9]{4}-[0-9]{2}-[0-9]{2}", PDF_SEARCH_REGEX), ==, 1);
+  g_assert_cmpint(search_one(fixture, "h.llo", PDF_SEARCH_REGEX), ==, 3);
+  g_assert_cmpint(search_one(fixture, "H.LLO", PDF_SEARCH_REGEX | PDF_SEARCH_CASE_SENSITIVE), ==, 1);
+  g_assert_cmpint(search_one(fixture, "world", PDF_SEARCH_REGEX | PDF_SEARCH_WHOLE_WORD), ==, 2);
+  g_assert_cmpint(search_one(fixture, "caf[e]", PDF_SEARCH_REGEX), ==, 0);
+  g_assert_cmpint(search_one(fixture, "caf[e]", PDF_SEARCH_REGEX | PDF_SEARCH_IGNORE_DIACRITICS), ==, 1);
+
+  zathura_error_t error        = ZATHURA_ERROR_OK;
+  int count                    = 0;
+  const pdf_search_term_t term = {.text = "(", .flags = PDF_SEARCH_REGEX};
+  g_assert_cmpint(search_count(fixture, &term, 1, &count, &error), ==, -1);
+  g_assert_cmpint(error, ==, ZATHURA_ERROR_INVALID_ARGUMENTS);
+
+  fixture_free(fixture);
+}
+
+static void test_search_terms(void) {
+  fixture_t* fixture = fixture_new_text(search_pages, G_N_ELEMENTS(search_pages));
+
+  const pdf_search_term_t terms[] = {
+      {.text = "hello", .flags = PDF_SEARCH_CASE_SENSITIVE},
+      {.text = "world", .flags = PDF_SEARCH_WHOLE_WORD},
+      {.text = "nai", .flags = PDF_SEARCH_IGNORE_DIACRITICS},
+      {.text = "[0-9]+", .flags = PDF_SEARCH_REGEX},
+  };
+  int counts[G_N_ELEMENTS(terms)];
+
+  g_assert_cmpint(search_count(fixture, terms, G_N_ELEMENTS(terms), counts, NULL), ==, 1 + 2 + 1 + 3);
+  g_assert_cmpint(counts[0], ==, 1);
+  g_assert_cmpint(counts[1], ==, 2);
+  g_assert_cmpint(counts[2], ==, 1);
+  g_assert_cmpint(counts[3], ==, 3);
+
+  fixture_free(fixture);
+}
+
+/* Pages of the document searches, every third page has no match and the others one or two */
+#define SEARCH_DOCUMENT_PAGES 24
+#define SEARCH_DOCUMENT_MATCHES(page) ((page) % 3)
+
+static fixture_t* search_document_new(void) {
+  char* pages[SEARCH_DOCUMENT_PAGES];
+  for (unsigned int page = 0; page < SEARCH_DOCUMENT_PAGES; ++page) {
+    GString* text = g_string_new(NULL);
+    g_string_append_printf(text, "Page %u", page);
+    for (unsigned int n = 0; n < SEARCH_DOCUMENT_MATCHES(page); ++n) {
+      g_string_append(text, "\nneedle in a haystack");
+    }
+    pages[page] = g_string_free(text, FALSE);
+  }
+
+  fixture_t* fixture = fixture_new_text((const char* const*)pages, SEARCH_DOCUMENT_PAGES);
+  for (unsigned int page = 0; page < SEARCH_DOCUMENT_PAGES; ++page) {
+    g_free(pages[page]);
+  }
+
+  return fixture;
+}
+
+static void assert_rectangles_equal(girara_list_t* rectangles, girara_list_t* expected) {
+  g_assert_cmpuint(girara_list_size(rectangles), ==, girara_list_size(expected));
+  for (size_t n = 0; n < girara_list_size(expected); ++n) {
+    const zathura_rectangle_t* rectangle          = girara_list_nth(rectangles, n);
+    const zathura_rectangle_t* expected_rectangle = girara_list_nth(expected, n);
+    g_assert_cmpfloat(rectangle->x1, ==, expected_rectangle->x1);
+    g_assert_cmpfloat(rectangle->y1, ==, expected_rectangle->y1);
+    g_assert_cmpfloat(rectangle->x2, ==, expected_rectangle->x2);
+    g_assert_cmpfloat(rectangle->y2, ==, expected_rectangle->y2);
+  }
+}
+
+/* Checks the results of a document search against searches of every single page */
+static void assert_document_results(fixture_t* fixture, girara_list_t* results) {
+  g_assert_nonnull(results);
+
+  size_t n = 0;
+  for (unsigned int index = 0; index < SEARCH_DOCUMENT_PAGES; ++index) {
+    zathura_page_t* page    = fixture_get_page(fixture, index);
+    girara_list_t* expected = pdf_page_search_text(page, zathura_page_get_data(page), "needle", NULL);
+    if (expected == NULL) {
+      g_assert_cmpuint(SEARCH_DOCUMENT_MATCHES(index), ==, 0);
+      continue;
+    }
+    g_assert_cmpuint(girara_list_size(expected), ==, SEARCH_DOCUMENT_MATCHES(index));
+
+    g_assert_cmpuint(n, <, girara_list_size(results));
+    const pdf_search_result_t* result = girara_list_nth(results, n++);
+    g_assert_cmpuint(result->page, ==, index);
+    assert_rectangles_equal(result->rectangles, expected);
+    girara_list_free(expected);
+  }
+
+  g_assert_cmpuint(n, ==, girara_list_size(results));
+}
+
+static void test_search_document(void) {
+  fixture_t* fixture = search_document_new();
+
+  zathura_error_t error  = ZATHURA_ERROR_OK;
+  girara_list_t* results = pdf_document_search_text(fixture->document, fixture->pdf_document, "needle", &error);
+  g_assert_cmpint(error, ==, ZATHURA_ERROR_OK);
+  assert_document_results(fixture, results);
+  girara_list_free(results);
+
+  g_assert_null(pdf_document_search_text(fixture->document, fixture->pdf_document, "zathura", &error));
+  g_assert_cmpint(error, ==, ZATHURA_ERROR_UNKNOWN);
+
+  fixture_free(fixture);
+}
+
+static void test_search_document_busy_pool(void) {
+  fixture_t* fixture = search_document_new();
+
+  /* with a single free document, the other workers give up right away and one worker searches every page */
+  GPtrArray* held = g_ptr_array_new();
+  for (unsigned int n = 1; n < pdf_document_pool_max_size(); ++n) {
+    PopplerDocument* poppler_document = pdf_document_pool_acquire(fixture->pdf_document);
+    g_assert_nonnull(poppler_document);
+    g_ptr_array_add(held, poppler_document);
+  }
+
+  zathura_error_t error  = ZATHURA_ERROR_OK;
+  girara_list_t* results = pdf_document_search_text(fixture->document, fixture->pdf_document, "needle", &error);
+  g_assert_cmpint(error, ==, ZATHURA_ERROR_OK);
+  assert_document_results(fixture, results);
+  girara_list_free(results);
+
+  for (guint n = 0; n < held->len; ++n) {
+    pdf_document_pool_release(fixture->pdf_document, g_ptr_array_index(held, n));
+  }
+  g_ptr_array_free(held, TRUE);
+
+  fixture_free(fixture);
+}
+
+/* Records the pages delivered by a streaming search */
+typedef struct search_stream_s {
+  GArray* pages;
+  unsigned int stop_after; /* Number of pages after which the callback stops the search (0 for all) */
+  GCancellable* cancel;    /* Cancelled on the first delivery if not NULL */
+} search_stream_t;
+
+static bool search_stream_callback(unsigned int page, girara_list_t* rectangles, void* data) {
+  search_stream_t* stream = data;
+
+  g_assert_cmpuint(page, <, SEARCH_DOCUMENT_PAGES);
+  g_assert_cmpuint(girara_list_size(rectangles), ==, SEARCH_DOCUMENT_MATCHES(page));
+  girara_list_free(rectangles);
+  g_array_append_val(stream->pages, page);
+
+  if (stream->cancel != NULL) {
+    g_cancellable_cancel(stream->cancel);
+  }
+
+  return stream->stop_after == 0 || stream->pages->len < stream->stop_after;
+}
+
+static zathura_error_t search_stream(fixture_t* fixture, unsigned int first_page, GCancellable* cancellable,
+                                     search_stream_t* stream) {
+  stream->pages = g_array_new(FALSE, FALSE, sizeof(unsigned int));
+
+  return pdf_document_search_text_streaming(fixture->document, fixture->pdf_document, "needle", first_page,
+                                            cancellable, search_stream_callback, stream);
+}
+
+/* Checks that the pages with matches were delivered in search order, starting at first_page and wrapping around */
+static void assert_stream_order(const search_stream_t* stream, unsigned int first_page, unsigned int n_pages) {
+  unsigned int n = 0;
+  for (unsigned int position = 0; position < SEARCH_DOCUMENT_PAGES && n < n_pages; ++position) {
+    const unsigned int page = (first_page + position) % SEARCH_DOCUMENT_PAGES;
+    if (SEARCH_DOCUMENT_MATCHES(page) != 0) {
+      g_assert_cmpuint(n, <, stream->pages->len);
+      g_assert_cmpuint(g_array_index(stream->pages, unsigned int, n), ==, page);
+      n++;
+    }
+  }
+
+  g_assert_cmpuint(stream->pages->len, ==, n);
+}
+
+static void test_search_streaming(void) {
+  fixture_t* fixture     = search_document_new();
+  search_stream_t stream = {0};
+
+  /* 16 of the 24 pages have matches */
+  g_assert_cmpint(search_stream(fixture, 10, NULL, &stream), ==, ZATHURA_ERROR_OK);
+  assert_stream_order(&stream, 10, SEARCH_DOCUMENT_PAGES);
+  g_assert_cmpuint(stream.pages->len, ==, 16);
+  g_array_unref(stream.pages);
+
+  g_assert_cmpint(search_stream(fixture, SEARCH_DOCUMENT_PAGES, NULL, &stream), ==, ZATHURA_ERROR_INVALID_ARGUMENTS);
+  g_assert_cmpuint(stream.pages->len, ==, 0);
+  g_array_unref(stream.pages);
+
+  fixture_free(fixture);
+}
+
+static void test_search_streaming_stop(void) {
+  fixture_t* fixture     = search_document_new();
+  search_stream_t stream = {.stop_after = 3};
+
+  /* the search stops after the page on which the callback returned false */
+  g_assert_cmpint(search_stream(fixture, 22, NULL, &stream), ==, ZATHURA_ERROR_OK);
+  assert_stream_order(&stream, 22, 3);
+  g_assert_cmpuint(stream.pages->len, ==, 3);
+  g_array_unref(stream.pages);
+
+  fixture_free(fixture);
+}
+
+static void test_search_streaming_cancel(void) {
+  fixture_t* fixture        = search_document_new();
+  GCancellable* cancellable = g_cancellable_new();
+  search_stream_t stream    = {.cancel = cancellable};
+
+  /* nothing is delivered after the cancellation, and the search reports it */
+  g_assert_cmpint(search_stream(fixture, 5, cancellable, &stream), ==, ZATHURA_ERROR_UNKNOWN);
+  g_assert_true(g_cancellable_is_cancelled(cancellable));
+  assert_stream_order(&stream, 5, 1);
+  g_assert_cmpuint(stream.pages->len, ==, 1);
+  g_array_unref(stream.pages);
+
+  /* a search that is cancelled before it starts delivers nothing */
+  stream.cancel = NULL;
+  g_assert_cmpint(search_stream(fixture, 5, cancellable, &stream), ==, ZATHURA_ERROR_UNKNOWN);
+  g_assert_cmpuint(stream.pages->len, ==, 0);
+  g_array_unref(stream.pages);
+
+  g_object_unref(cancellable);
+  fixture_free(fixture);
+}
+
+/* More pages than the text cache used to keep, the layouts of all of them fit into the default budget */
+#define SEARCH_REPEATED_PAGES 200
+
+static void test_search_repeated(void) {
+  char* pages[SEARCH_REPEATED_PAGES];
+  for (unsigned int page = 0; page < SEARCH_REPEATED_PAGES; ++page) {
+    pages[page] = g_strdup_printf("Page %u\nneedle in a haystack", page);
+  }
+  fixture_t* fixture = fixture_new_text((const char* const*)pages, SEARCH_REPEATED_PAGES);
+  for (unsigned int page = 0; page < SEARCH_REPEATED_PAGES; ++page) {
+    g_free(pages[page]);
+  }
+
+  pdf_text_t* layouts[SEARCH_REPEATED_PAGES];
+  for (unsigned int pass = 0; pass < 2; ++pass) {
+    for (unsigned int index = 0; index < SEARCH_REPEATED_PAGES; ++index) {
+      zathura_page_t* page  = fixture_get_page(fixture, index);
+      pdf_page_t* pdf_page  = zathura_page_get_data(page);
+      girara_list_t* result = pdf_page_search_text(page, pdf_page, "needle", NULL);
+      g_assert_nonnull(result);
+      g_assert_cmpuint(girara_list_size(result), ==, 1);
+      girara_list_free(result);
+
+      /* the second pass finds the layouts of the first one instead of extracting the text again */
+      g_assert_nonnull(pdf_page->text);
+      if (pass == 0) {
+        layouts[index] = pdf_page_get_text_layout(pdf_page);
+      } else {
+        g_assert_true(pdf_page->text == layouts[index]);
+      }
+    }
+  }
+
+  for (unsigned int index = 0; index < SEARCH_REPEATED_PAGES; ++index) {
+    pdf_text_unref(layouts[index]);
+  }
+  fixture_free(fixture);
+}
+
+int main(int argc, char* argv[]) {
+  g_test_init(&argc, &argv, NULL);
+
+  g_test_add_func("/search/default", test_search_default);
+  g_test_add_func("/search/case-sensitive", test_search_case_sensitive);
+  g_test_add_func("/search/whole-word", test_search_whole_word);
+  g_test_add_func("/search/ignore-diacritics", test_search_ignore_diacritics);
+  g_test_add_func("/search/regex", test_search_regex);
+  g_test_add_func("/search/terms", test_search_terms);
+  g_test_add_func("/search/repeated", test_search_repeated);
+  g_test_add_func("/search/document", test_search_document);
+  g_test_add_func("/search/document-busy-pool", test_search_document_busy_pool);
+  g_test_add_func("/search/streaming", test_search_streaming);
+  g_test_add_func("/search/streaming-stop", test_search_streaming_stop);
+  g_test_add_func("/search/streaming-cancel", test_search_streaming_cancel);
+
+  return g_test_run();
+}
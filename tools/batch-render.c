@@ -0,0 +1,464 @@
+/* SPDX-License-Identifier: Zlib */
+
+/*
+ * Renders page ranges of a document without zathura and reports the throughput. Every worker thread opens the
+ * document on its own, so the workers never share a poppler document. The pages are split into contiguous ranges,
+ * one per worker; a worker that runs out of pages steals the second half of the largest remaining range.
+ */
+
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cache.h"
+#include "host.h"
+#include "plugin.h"
+#include "prefetch.h"
+
+#define RENDER_DPI 96
+
+typedef enum render_format_e {
+  RENDER_FORMAT_NONE,
+  RENDER_FORMAT_PNG,
+  RENDER_FORMAT_PAM,
+  RENDER_FORMAT_RAW,
+} render_format_t;
+
+typedef struct render_job_s render_job_t;
+
+/* Pages [begin, end) of the job's page list that are left to a worker */
+typedef struct render_worker_s {
+  render_job_t* job;
+  unsigned int id;
+  zathura_document_t* document; /* Document owned by the worker */
+  GThread* thread;
+
+  GMutex lock;
+  unsigned int begin;
+  unsigned int end;
+
+  unsigned int rendered; /* Number of rendered pages */
+  unsigned int steals;   /* Number of stolen ranges */
+  bool failed;           /* Whether rendering a page failed */
+} render_worker_t;
+
+struct render_job_s {
+  const char* path;
+  const char* output; /* Output directory (optional) */
+  render_format_t format;
+  double scale;
+
+  GArray* pages; /* Page indices */
+  render_worker_t* workers;
+  unsigned int n_workers;
+};
+
+static gint64 render_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static zathura_document_t* render_document_open(const char* path) {
+  zathura_document_t* document = host_document_new(path);
+  if (pdf_document_open(document) != ZATHURA_ERROR_OK) {
+    host_document_free(document);
+    return NULL;
+  }
+
+  host_document_create_pages(document);
+  return document;
+}
+
+static void render_document_free(zathura_document_t* document) {
+  const unsigned int number_of_pages = zathura_document_get_number_of_pages(document);
+  for (unsigned int index = 0; index < number_of_pages; ++index) {
+    zathura_page_t* page = zathura_document_get_page(document, index);
+    if (zathura_page_get_data(page) != NULL) {
+      pdf_page_clear(page, zathura_page_get_data(page));
+    }
+  }
+
+  pdf_document_free(document, zathura_document_get_data(document));
+  host_document_free(document);
+}
+
+/* Takes the next page of the worker's own range */
+static bool render_worker_take(render_worker_t* worker, unsigned int* position) {
+  g_mutex_lock(&worker->lock);
+  const bool found = worker->begin < worker->end;
+  if (found == true) {
+    *position = worker->begin++;
+  }
+  g_mutex_unlock(&worker->lock);
+
+  return found;
+}
+
+/* Moves the second half of the largest remaining range of another worker to the worker */
+static bool render_worker_steal(render_worker_t* worker) {
+  render_job_t* job = worker->job;
+
+  while (true) {
+    render_worker_t* victim = NULL;
+    unsigned int remaining  = 0;
+    for (unsigned int n = 1; n < job->n_workers; ++n) {
+      render_worker_t* candidate = &job->workers[(worker->id + n) % job->n_workers];
+      g_mutex_lock(&candidate->lock);
+      if (candidate->end - candidate->begin > remaining) {
+        remaining = candidate->end - candidate->begin;
+        victim    = candidate;
+      }
+      g_mutex_unlock(&candidate->lock);
+    }
+
+    if (victim == NULL) {
+      return false;
+    }
+
+    /* the range might have shrunk since it was inspected */
+    g_mutex_lock(&victim->lock);
+    remaining = victim->end - victim->begin;
+    if (remaining == 0) {
+      g_mutex_unlock(&victim->lock);
+      continue;
+    }
+    const unsigned int stolen = (remaining + 1) / 2;
+    const unsigned int end    = victim->end;
+    victim->end -= stolen;
+    g_mutex_unlock(&victim->lock);
+
+    g_mutex_lock(&worker->lock);
+    worker->begin = end - stolen;
+    worker->end   = end;
+    g_mutex_unlock(&worker->lock);
+
+    worker->steals++;
+    return true;
+  }
+}
+
+static bool render_write_pam(cairo_surface_t* surface, const char* filename) {
+  FILE* file = g_fopen(filename, "wb");
+  if (file == NULL) {
+    return false;
+  }
+
+  const int width           = cairo_image_surface_get_width(surface);
+  const int height          = cairo_image_surface_get_height(surface);
+  const int stride          = cairo_image_surface_get_stride(surface);
+  const unsigned char* data = cairo_image_surface_get_data(surface);
+  unsigned char* row        = g_malloc_n(width, 3);
+
+  fprintf(file, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 3\nMAXVAL 255\nTUPLTYPE RGB\nENDHDR\n", width, height);
+  for (int y = 0; y < height; ++y) {
+    const guint32* pixels = (const guint32*)(data + (size_t)y * stride);
+    for (int x = 0; x < width; ++x) {
+      row[3 * x]     = (pixels[x] >> 16) & 0xff;
+      row[3 * x + 1] = (pixels[x] >> 8) & 0xff;
+      row[3 * x + 2] = pixels[x] & 0xff;
+    }
+    fwrite(row, 3, width, file);
+  }
+  g_free(row);
+
+  const bool ret = ferror(file) == 0;
+  return fclose(file) == 0 && ret;
+}
+
+/* Writes the rows without padding as native-endian 32-bit xRGB pixels */
+static bool render_write_raw(cairo_surface_t* surface, const char* filename) {
+  FILE* file = g_fopen(filename, "wb");
+  if (file == NULL) {
+    return false;
+  }
+
+  const int width           = cairo_image_surface_get_width(surface);
+  const int height          = cairo_image_surface_get_height(surface);
+  const int stride          = cairo_image_surface_get_stride(surface);
+  const unsigned char* data = cairo_image_surface_get_data(surface);
+
+  for (int y = 0; y < height; ++y) {
+    fwrite(data + (size_t)y * stride, 4, width, file);
+  }
+
+  const bool ret = ferror(file) == 0;
+  return fclose(file) == 0 && ret;
+}
+
+static bool render_write(render_job_t* job, cairo_surface_t* surface, unsigned int index) {
+  char* filename = NULL;
+  switch (job->format) {
+  case RENDER_FORMAT_PNG:
+    filename = g_strdup_printf("%s/page-%05u.png", job->output, index + 1);
+    break;
+  case RENDER_FORMAT_PAM:
+    filename = g_strdup_printf("%s/page-%05u.pam", job->output, index + 1);
+    break;
+  case RENDER_FORMAT_RAW:
+    filename = g_strdup_printf("%s/page-%05u-%dx%d.raw", job->output, index + 1,
+                               cairo_image_surface_get_width(surface), cairo_image_surface_get_height(surface));
+    break;
+  default:
+    return true;
+  }
+
+  bool ret = false;
+  switch (job->format) {
+  case RENDER_FORMAT_PNG:
+    ret = cairo_surface_write_to_png(surface, filename) == CAIRO_STATUS_SUCCESS;
+    break;
+  case RENDER_FORMAT_PAM:
+    ret = render_write_pam(surface, filename);
+    break;
+  default:
+    ret = render_write_raw(surface, filename);
+    break;
+  }
+
+  if (ret == false) {
+    fprintf(stderr, "failed to write %s\n", filename);
+  }
+  g_free(filename);
+
+  return ret;
+}
+
+static bool render_page(render_job_t* job, zathura_document_t* document, unsigned int index) {
+  zathura_page_t* page = zathura_document_get_page(document, index);
+  if (zathura_page_get_data(page) == NULL && pdf_page_init(page) != ZATHURA_ERROR_OK) {
+    return false;
+  }
+
+  const int width  = MAX(1, ceil(zathura_page_get_width(page) * job->scale));
+  const int height = MAX(1, ceil(zathura_page_get_height(page) * job->scale));
+
+  cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    return false;
+  }
+
+  cairo_t* cairo = cairo_create(surface);
+  cairo_set_source_rgb(cairo, 1, 1, 1);
+  cairo_paint(cairo);
+  cairo_scale(cairo, job->scale, job->scale);
+
+  bool ret = pdf_page_render_cairo(page, zathura_page_get_data(page), cairo, false) == ZATHURA_ERROR_OK;
+  cairo_destroy(cairo);
+  cairo_surface_flush(surface);
+
+  if (ret == true) {
+    ret = render_write(job, surface, index);
+  }
+  cairo_surface_destroy(surface);
+
+  return ret;
+}
+
+static gpointer render_worker_run(gpointer data) {
+  render_worker_t* worker = data;
+  render_job_t* job       = worker->job;
+
+  if (worker->document == NULL) {
+    worker->document = render_document_open(job->path);
+    if (worker->document == NULL) {
+      /* the pages of the worker are stolen by the others */
+      fprintf(stderr, "worker %u: failed to open %s\n", worker->id, job->path);
+      worker->failed = true;
+      return NULL;
+    }
+  }
+
+  unsigned int position = 0;
+  while (true) {
+    if (render_worker_take(worker, &position) == false) {
+      if (render_worker_steal(worker) == false) {
+        break;
+      }
+      continue;
+    }
+
+    const unsigned int index = g_array_index(job->pages, unsigned int, position);
+    if (render_page(job, worker->document, index) == true) {
+      worker->rendered++;
+    } else {
+      fprintf(stderr, "failed to render page %u\n", index + 1);
+      worker->failed = true;
+    }
+  }
+
+  return NULL;
+}
+
+/* Parses a comma separated list of 1-based pages and ranges, e.g. "1-10,12,20-" */
+static GArray* render_parse_pages(const char* ranges, unsigned int number_of_pages) {
+  GArray* pages = g_array_new(FALSE, FALSE, sizeof(unsigned int));
+  if (ranges == NULL) {
+    for (unsigned int index = 0; index < number_of_pages; ++index) {
+      g_array_append_val(pages, index);
+    }
+    return pages;
+  }
+
+  char** parts = g_strsplit(ranges, ",", -1);
+  for (char** part = parts; *part != NULL; ++part) {
+    char* end           = NULL;
+    const guint64 first = g_ascii_strtoull(*part, &end, 10);
+    guint64 last        = first;
+    if (*end == '-') {
+      const char* next = end + 1;
+      last             = *next != '\0' ? g_ascii_strtoull(next, &end, 10) : number_of_pages;
+      if (*next == '\0') {
+        end = (char*)next;
+      }
+    }
+
+    if (*end != '\0' || first < 1 || last < first || last > number_of_pages) {
+      fprintf(stderr, "invalid page range '%s' (document has %u pages)\n", *part, number_of_pages);
+      g_array_unref(pages);
+      pages = NULL;
+      break;
+    }
+
+    for (guint64 page = first; page <= last; ++page) {
+      const unsigned int index = page - 1;
+      g_array_append_val(pages, index);
+    }
+  }
+  g_strfreev(parts);
+
+  return pages;
+}
+
+static render_format_t render_parse_format(const char* format) {
+  if (strcmp(format, "png") == 0) {
+    return RENDER_FORMAT_PNG;
+  } else if (strcmp(format, "pam") == 0) {
+    return RENDER_FORMAT_PAM;
+  } else if (strcmp(format, "raw") == 0) {
+    return RENDER_FORMAT_RAW;
+  }
+
+  return RENDER_FORMAT_NONE;
+}
+
+int main(int argc, char* argv[]) {
+  const char* output     = NULL;
+  const char* ranges     = NULL;
+  const char* format     = "png";
+  double dpi             = RENDER_DPI;
+  unsigned int n_threads = g_get_num_processors();
+
+  int argi = 1;
+  for (; argi < argc && strncmp(argv[argi], "--", 2) == 0; ++argi) {
+    if (strcmp(argv[argi], "--output") == 0 && argi + 1 < argc) {
+      output = argv[++argi];
+    } else if (strcmp(argv[argi], "--format") == 0 && argi + 1 < argc) {
+      format = argv[++argi];
+    } else if (strcmp(argv[argi], "--pages") == 0 && argi + 1 < argc) {
+      ranges = argv[++argi];
+    } else if (strcmp(argv[argi], "--dpi") == 0 && argi + 1 < argc) {
+      dpi = g_ascii_strtod(argv[++argi], NULL);
+    } else if (strcmp(argv[argi], "--threads") == 0 && argi + 1 < argc) {
+      n_threads = MAX(1, atoi(argv[++argi]));
+    } else {
+      break;
+    }
+  }
+
+  render_job_t job = {
+      .output = output,
+      .format = output != NULL ? render_parse_format(format) : RENDER_FORMAT_NONE,
+      .scale  = dpi / 72,
+  };
+
+  if (argc - argi != 1 || dpi <= 0 || (output != NULL && job.format == RENDER_FORMAT_NONE)) {
+    fprintf(stderr,
+            "usage: %s [--output DIR] [--format png|pam|raw] [--pages RANGES] [--dpi DPI] [--threads N] FILE\n",
+            argv[0]);
+    return 1;
+  }
+
+  if (output != NULL && g_mkdir_with_parents(output, 0755) != 0) {
+    fprintf(stderr, "failed to create %s: %s\n", output, g_strerror(errno));
+    return 1;
+  }
+
+  /* every page is rendered once, so caching the results is wasted work */
+  g_setenv(PDF_RENDER_CACHE_ENV, "0", FALSE);
+  /* prefetching would extract text and links of the following pages on extra documents, nothing uses them here */
+  g_setenv(PDF_PREFETCH_ENV, "0", FALSE);
+
+  char* path = g_canonicalize_filename(argv[argi], NULL);
+  job.path   = path;
+
+  const gint64 start = render_now();
+
+  /* the first worker reuses the document that determines the number of pages */
+  zathura_document_t* document = render_document_open(path);
+  if (document == NULL) {
+    fprintf(stderr, "failed to open %s\n", path);
+    g_free(path);
+    return 1;
+  }
+
+  job.pages = render_parse_pages(ranges, zathura_document_get_number_of_pages(document));
+  if (job.pages == NULL) {
+    render_document_free(document);
+    g_free(path);
+    return 1;
+  }
+
+  job.n_workers = MAX(1, MIN(n_threads, job.pages->len));
+  job.workers   = g_malloc0_n(job.n_workers, sizeof(render_worker_t));
+  for (unsigned int n = 0; n < job.n_workers; ++n) {
+    render_worker_t* worker = &job.workers[n];
+    worker->job             = &job;
+    worker->id              = n;
+    worker->begin           = (guint64)job.pages->len * n / job.n_workers;
+    worker->end             = (guint64)job.pages->len * (n + 1) / job.n_workers;
+    g_mutex_init(&worker->lock);
+  }
+  job.workers[0].document = document;
+
+  for (unsigned int n = 1; n < job.n_workers; ++n) {
+    job.workers[n].thread = g_thread_new("render-worker", render_worker_run, &job.workers[n]);
+  }
+  render_worker_run(&job.workers[0]);
+
+  unsigned int rendered = 0;
+  unsigned int steals   = 0;
+  bool failed           = false;
+  for (unsigned int n = 0; n < job.n_workers; ++n) {
+    render_worker_t* worker = &job.workers[n];
+    if (worker->thread != NULL) {
+      g_thread_join(worker->thread);
+    }
+    rendered += worker->rendered;
+    steals += worker->steals;
+    failed |= worker->failed;
+  }
+
+  const double seconds = (render_now() - start) / 1e9;
+  printf("rendered %u of %u pages in %.3f s (%.1f pages/s, %u threads, %u steals)\n", rendered, job.pages->len,
+         seconds, rendered / seconds, job.n_workers, steals);
+
+  for (unsigned int n = 0; n < job.n_workers; ++n) {
+    render_worker_t* worker = &job.workers[n];
+    if (worker->document != NULL) {
+      render_document_free(worker->document);
+    }
+    g_mutex_clear(&worker->lock);
+  }
+  const unsigned int requested = job.pages->len;
+  g_free(job.workers);
+  g_array_unref(job.pages);
+  g_free(path);
+
+  return failed == true || rendered < requested ? 1 : 0;
+}
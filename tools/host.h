@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: Zlib */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <zathura/plugin-api.h>
+
+/*
+ * Minimal implementation of the parts of zathura's document and page API that the plugin uses, so that the plugin
+ * can be driven without a running zathura instance.
+ */
+
+/**
+ * Creates a document for the given file
+ *
+ * @param path Path of the file
+ * @return The document
+ */
+zathura_document_t* host_document_new(const char* path);
+
+/**
+ * Frees a document and its pages. The plugin data has to be freed before.
+ *
+ * @param document The document
+ */
+void host_document_free(zathura_document_t* document);
+
+/**
+ * Creates the pages of a document after it has been opened by the plugin
+ *
+ * @param document The document
+ */
+void host_document_create_pages(zathura_document_t* document);
+
+#endif // HOST_H
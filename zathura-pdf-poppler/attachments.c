@@ -1,8 +1,104 @@
 /* SPDX-License-Identifier: Zlib */
 
+#include <errno.h>
+#include <fcntl.h>
 #include <girara/utils.h>
+#include <glib/gstdio.h>
+#include <unistd.h>
 
 #include "plugin.h"
+#include "attachments.h"
+
+static void attachment_info_free(void* data) {
+  pdf_attachment_info_t* info = data;
+  if (info == NULL) {
+    return;
+  }
+
+  g_free(info->name);
+  g_free(info->checksum);
+  g_free(info->mime_type);
+  g_free(info);
+}
+
+void pdf_document_attachments_init(pdf_document_t* pdf_document) {
+  pdf_document->attachments.catalogue   = NULL;
+  pdf_document->attachments.attachments = NULL;
+  pdf_document->attachments.names       = NULL;
+  g_mutex_init(&pdf_document->attachments.lock);
+}
+
+void pdf_document_attachments_clear(pdf_document_t* pdf_document) {
+  if (pdf_document->attachments.names != NULL) {
+    g_hash_table_unref(pdf_document->attachments.names);
+  }
+  if (pdf_document->attachments.attachments != NULL) {
+    g_ptr_array_unref(pdf_document->attachments.attachments);
+  }
+  if (pdf_document->attachments.catalogue != NULL) {
+    g_ptr_array_unref(pdf_document->attachments.catalogue);
+  }
+  g_mutex_clear(&pdf_document->attachments.lock);
+}
+
+static char* checksum_to_string(GString* checksum) {
+  if (checksum == NULL || checksum->len == 0) {
+    return NULL;
+  }
+
+  GString* hex = g_string_sized_new(checksum->len * 2);
+  for (gsize i = 0; i < checksum->len; ++i) {
+    g_string_append_printf(hex, "%02x", (guchar)checksum->str[i]);
+  }
+
+  return g_string_free(hex, FALSE);
+}
+
+/*
+ * Builds the catalogue on first use. poppler only reads the data of an embedded file when it is saved, so the
+ * attachment objects are kept to save from later. Needs to be called with the lock held.
+ */
+static void attachments_load(pdf_document_t* pdf_document) {
+  if (pdf_document->attachments.catalogue != NULL) {
+    return;
+  }
+
+  pdf_document->attachments.catalogue   = g_ptr_array_new_with_free_func(attachment_info_free);
+  pdf_document->attachments.attachments = g_ptr_array_new_with_free_func(g_object_unref);
+  pdf_document->attachments.names       = g_hash_table_new(g_str_hash, g_str_equal);
+
+  if (poppler_document_has_attachments(pdf_document->document) == FALSE) {
+    return;
+  }
+
+  GList* attachment_list = poppler_document_get_attachments(pdf_document->document);
+  for (GList* attachments = attachment_list; attachments != NULL; attachments = g_list_next(attachments)) {
+    PopplerAttachment* attachment = (PopplerAttachment*)attachments->data;
+
+    pdf_attachment_info_t* info = g_try_malloc0(sizeof(pdf_attachment_info_t));
+    if (info == NULL) {
+      g_object_unref(attachment);
+      continue;
+    }
+
+    info->name     = g_strdup(attachment->name);
+    info->size     = attachment->size;
+    info->checksum = checksum_to_string(attachment->checksum);
+
+    char* content_type = g_content_type_guess(info->name, NULL, 0, NULL);
+    info->mime_type    = g_content_type_get_mime_type(content_type);
+    g_free(content_type);
+
+    g_ptr_array_add(pdf_document->attachments.catalogue, info);
+    g_ptr_array_add(pdf_document->attachments.attachments, attachment);
+
+    /* the first attachment wins if names are not unique */
+    if (info->name != NULL && g_hash_table_contains(pdf_document->attachments.names, info->name) == FALSE) {
+      g_hash_table_insert(pdf_document->attachments.names, info->name, attachment);
+    }
+  }
+  g_list_free(attachment_list);
+}
 
 girara_list_t* pdf_document_attachments_get(zathura_document_t* document, void* data, zathura_error_t* error) {
   if (document == NULL || data == NULL) {
@@ -10,8 +106,8 @@ girara_list_t* pdf_document_attachments_get(zathura_document_t* document, void*
     return NULL;
   }
 
-  PopplerDocument* poppler_document = data;
-  if (poppler_document_has_attachments(poppler_document) == FALSE) {
+  pdf_document_t* pdf_document = data;
+  if (poppler_document_has_attachments(pdf_document->document) == FALSE) {
     girara_warning("PDF file has no attachments");
     return NULL;
   }
@@ -22,40 +118,96 @@ girara_list_t* pdf_document_attachments_get(zathura_document_t* document, void*
     return NULL;
   }
 
-  GList* attachment_list = poppler_document_get_attachments(poppler_document);
-  for (GList* attachments = attachment_list; attachments != NULL; attachments = g_list_next(attachments)) {
-    PopplerAttachment* attachment = (PopplerAttachment*)attachments->data;
-    girara_list_append(res, g_strdup(attachment->name));
+  g_mutex_lock(&pdf_document->attachments.lock);
+  attachments_load(pdf_document);
+  for (guint n = 0; n < pdf_document->attachments.catalogue->len; ++n) {
+    pdf_attachment_info_t* info = g_ptr_array_index(pdf_document->attachments.catalogue, n);
+    girara_list_append(res, g_strdup(info->name));
+  }
+  g_mutex_unlock(&pdf_document->attachments.lock);
+
+  return res;
+}
+
+girara_list_t* pdf_document_attachments_get_catalogue(zathura_document_t* document, void* data,
+                                                      zathura_error_t* error) {
+  if (document == NULL || data == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_INVALID_ARGUMENTS);
+    return NULL;
+  }
+
+  pdf_document_t* pdf_document = data;
+
+  girara_list_t* res = girara_list_new();
+  if (res == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+    return NULL;
+  }
+
+  g_mutex_lock(&pdf_document->attachments.lock);
+  attachments_load(pdf_document);
+  for (guint n = 0; n < pdf_document->attachments.catalogue->len; ++n) {
+    girara_list_append(res, g_ptr_array_index(pdf_document->attachments.catalogue, n));
   }
-  g_list_free_full(attachment_list, g_object_unref);
+  g_mutex_unlock(&pdf_document->attachments.lock);
 
   return res;
 }
 
+static gboolean attachment_write(const gchar* buf, gsize count, gpointer data, GError** error) {
+  const int fd = GPOINTER_TO_INT(data);
+
+  while (count > 0) {
+    const ssize_t written = write(fd, buf, count);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      g_set_error_literal(error, G_FILE_ERROR, g_file_error_from_errno(errno), g_strerror(errno));
+      return FALSE;
+    }
+
+    buf += written;
+    count -= written;
+  }
+
+  return TRUE;
+}
+
 zathura_error_t pdf_document_attachment_save(zathura_document_t* document, void* data, const char* attachmentname,
                                              const char* file) {
-  if (document == NULL || data == NULL) {
+  if (document == NULL || data == NULL || attachmentname == NULL || file == NULL) {
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
-  PopplerDocument* poppler_document = data;
-  if (poppler_document_has_attachments(poppler_document) == FALSE) {
+  pdf_document_t* pdf_document = data;
+  if (poppler_document_has_attachments(pdf_document->document) == FALSE) {
     girara_warning("PDF file has no attachments");
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
-  zathura_error_t ret = ZATHURA_ERROR_OK;
-  GList* attachment_list = poppler_document_get_attachments(poppler_document);
-  for (GList* attachments = attachment_list; attachments != NULL; attachments = g_list_next(attachments)) {
-    PopplerAttachment* attachment = (PopplerAttachment*)attachments->data;
-    if (g_strcmp0(attachment->name, attachmentname) != 0) {
-      continue;
-    }
+  g_mutex_lock(&pdf_document->attachments.lock);
+  attachments_load(pdf_document);
+
+  PopplerAttachment* attachment = g_hash_table_lookup(pdf_document->attachments.names, attachmentname);
+  if (attachment == NULL) {
+    g_mutex_unlock(&pdf_document->attachments.lock);
+    return ZATHURA_ERROR_OK;
+  }
+
+  const int fd = g_open(file, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd == -1) {
+    g_mutex_unlock(&pdf_document->attachments.lock);
+    return ZATHURA_ERROR_UNKNOWN;
+  }
+
+  /* poppler streams the embedded file to the callback in small chunks */
+  const gboolean saved = poppler_attachment_save_to_callback(attachment, attachment_write, GINT_TO_POINTER(fd), NULL);
+  g_mutex_unlock(&pdf_document->attachments.lock);
 
-    ret = poppler_attachment_save(attachment, file, NULL) ? ZATHURA_ERROR_OK : ZATHURA_ERROR_UNKNOWN;
-    break;
+  if (g_close(fd, NULL) == FALSE || saved == FALSE) {
+    return ZATHURA_ERROR_UNKNOWN;
   }
 
-  g_list_free_full(attachment_list, g_object_unref);
-  return ret;
+  return ZATHURA_ERROR_OK;
 }
@@ -0,0 +1,22 @@
+/* SPDX-License-Identifier: Zlib */
+
+#ifndef ATTACHMENTS_H
+#define ATTACHMENTS_H
+
+#include "plugin.h"
+
+/**
+ * Initializes the attachment catalogue of a document
+ *
+ * @param pdf_document The document
+ */
+void pdf_document_attachments_init(pdf_document_t* pdf_document);
+
+/**
+ * Frees the attachment catalogue of a document
+ *
+ * @param pdf_document The document
+ */
+void pdf_document_attachments_clear(pdf_document_t* pdf_document);
+
+#endif // ATTACHMENTS_H
@@ -0,0 +1,203 @@
+/* SPDX-License-Identifier: Zlib */
+
+#include "automaton.h"
+
+#define AUTOMATON_ROOT 0
+
+typedef struct automaton_edge_s {
+  gunichar c; /* Character */
+  guint next; /* Target state */
+} automaton_edge_t;
+
+typedef struct automaton_state_s {
+  GArray* edges;    /* Outgoing edges sorted by character */
+  guint fail;       /* Longest proper suffix that is also a prefix of a pattern */
+  guint output;     /* Closest state on the failure chain that ends patterns (root if none) */
+  guint depth;      /* Length of the prefix */
+  GArray* patterns; /* Identifiers of the patterns ending here (NULL if none) */
+} automaton_state_t;
+
+struct pdf_automaton_s {
+  GArray* states;
+};
+
+static automaton_state_t* automaton_state(const pdf_automaton_t* automaton, guint state) {
+  return &g_array_index(automaton->states, automaton_state_t, state);
+}
+
+static guint automaton_add_state(pdf_automaton_t* automaton, guint depth) {
+  automaton_state_t state = {
+      .edges = g_array_new(FALSE, FALSE, sizeof(automaton_edge_t)),
+      .depth = depth,
+  };
+  g_array_append_val(automaton->states, state);
+
+  return automaton->states->len - 1;
+}
+
+/* Binary search for the edge of a character, returns the insertion position if there is none */
+static guint automaton_find_edge(const automaton_state_t* state, gunichar c, bool* found) {
+  guint low  = 0;
+  guint high = state->edges->len;
+  while (low < high) {
+    const guint middle           = low + (high - low) / 2;
+    const automaton_edge_t* edge = &g_array_index(state->edges, automaton_edge_t, middle);
+    if (edge->c == c) {
+      *found = true;
+      return middle;
+    }
+    if (edge->c < c) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  *found = false;
+  return low;
+}
+
+static bool automaton_goto(const pdf_automaton_t* automaton, guint state, gunichar c, guint* next) {
+  const automaton_state_t* current = automaton_state(automaton, state);
+
+  bool found           = false;
+  const guint position = automaton_find_edge(current, c, &found);
+  if (found == true) {
+    *next = g_array_index(current->edges, automaton_edge_t, position).next;
+  }
+
+  return found;
+}
+
+pdf_automaton_t* pdf_automaton_new(void) {
+  pdf_automaton_t* automaton = g_try_malloc0(sizeof(pdf_automaton_t));
+  if (automaton == NULL) {
+    return NULL;
+  }
+
+  automaton->states = g_array_new(FALSE, FALSE, sizeof(automaton_state_t));
+  automaton_add_state(automaton, 0);
+
+  return automaton;
+}
+
+void pdf_automaton_free(pdf_automaton_t* automaton) {
+  if (automaton == NULL) {
+    return;
+  }
+
+  for (guint n = 0; n < automaton->states->len; ++n) {
+    automaton_state_t* state = automaton_state(automaton, n);
+    g_array_unref(state->edges);
+    if (state->patterns != NULL) {
+      g_array_unref(state->patterns);
+    }
+  }
+  g_array_unref(automaton->states);
+  g_free(automaton);
+}
+
+void pdf_automaton_add(pdf_automaton_t* automaton, const gunichar* pattern, guint length, guint id) {
+  if (automaton == NULL || pattern == NULL || length == 0) {
+    return;
+  }
+
+  guint state = AUTOMATON_ROOT;
+  for (guint i = 0; i < length; ++i) {
+    bool found           = false;
+    const guint position = automaton_find_edge(automaton_state(automaton, state), pattern[i], &found);
+    if (found == true) {
+      state = g_array_index(automaton_state(automaton, state)->edges, automaton_edge_t, position).next;
+      continue;
+    }
+
+    /* adding a state may move the states array, so the edge is inserted afterwards */
+    const guint next            = automaton_add_state(automaton, i + 1);
+    const automaton_edge_t edge = {.c = pattern[i], .next = next};
+    g_array_insert_val(automaton_state(automaton, state)->edges, position, edge);
+    state = next;
+  }
+
+  automaton_state_t* last = automaton_state(automaton, state);
+  if (last->patterns == NULL) {
+    last->patterns = g_array_new(FALSE, FALSE, sizeof(guint));
+  }
+  g_array_append_val(last->patterns, id);
+}
+
+void pdf_automaton_build(pdf_automaton_t* automaton) {
+  if (automaton == NULL) {
+    return;
+  }
+
+  /* breadth-first, so that the failure links of shallower states are known */
+  GQueue queue = G_QUEUE_INIT;
+  g_queue_push_tail(&queue, GUINT_TO_POINTER(AUTOMATON_ROOT));
+
+  while (g_queue_is_empty(&queue) == FALSE) {
+    const guint parent = GPOINTER_TO_UINT(g_queue_pop_head(&queue));
+    GArray* edges      = automaton_state(automaton, parent)->edges;
+
+    for (guint n = 0; n < edges->len; ++n) {
+      const automaton_edge_t* edge = &g_array_index(edges, automaton_edge_t, n);
+      automaton_state_t* child     = automaton_state(automaton, edge->next);
+
+      /* follow the failure links of the parent until one of them continues with the character */
+      guint fail = AUTOMATON_ROOT;
+      if (parent != AUTOMATON_ROOT) {
+        guint candidate = automaton_state(automaton, parent)->fail;
+        while (automaton_goto(automaton, candidate, edge->c, &fail) == false) {
+          if (candidate == AUTOMATON_ROOT) {
+            fail = AUTOMATON_ROOT;
+            break;
+          }
+          candidate = automaton_state(automaton, candidate)->fail;
+        }
+      }
+
+      const automaton_state_t* fallback = automaton_state(automaton, fail);
+      child->fail                       = fail;
+      child->output                     = fallback->patterns != NULL ? fail : fallback->output;
+
+      g_queue_push_tail(&queue, GUINT_TO_POINTER(edge->next));
+    }
+  }
+}
+
+guint pdf_automaton_start(void) {
+  return AUTOMATON_ROOT;
+}
+
+guint pdf_automaton_next(const pdf_automaton_t* automaton, guint state, gunichar c) {
+  guint next = AUTOMATON_ROOT;
+  while (automaton_goto(automaton, state, c, &next) == false) {
+    if (state == AUTOMATON_ROOT) {
+      return AUTOMATON_ROOT;
+    }
+    state = automaton_state(automaton, state)->fail;
+  }
+
+  return next;
+}
+
+bool pdf_automaton_foreach_match(const pdf_automaton_t* automaton, guint state, pdf_automaton_match_func_t func,
+                                 void* data) {
+  const automaton_state_t* current = automaton_state(automaton, state);
+  if (current->patterns == NULL) {
+    state   = current->output;
+    current = automaton_state(automaton, state);
+  }
+
+  while (state != AUTOMATON_ROOT) {
+    for (guint n = 0; n < current->patterns->len; ++n) {
+      if (func(g_array_index(current->patterns, guint, n), current->depth, data) == false) {
+        return false;
+      }
+    }
+
+    state   = current->output;
+    current = automaton_state(automaton, state);
+  }
+
+  return true;
+}
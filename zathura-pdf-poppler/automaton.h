@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: Zlib */
+
+#ifndef AUTOMATON_H
+#define AUTOMATON_H
+
+#include "plugin.h"
+
+/**
+ * Aho-Corasick automaton that finds any number of patterns in a single pass
+ * over a sequence of characters
+ */
+typedef struct pdf_automaton_s pdf_automaton_t;
+
+/**
+ * Called for every pattern that ends at the current position
+ *
+ * @param id Identifier of the pattern
+ * @param length Length of the pattern
+ * @param data User data
+ * @return false to stop reporting matches
+ */
+typedef bool (*pdf_automaton_match_func_t)(guint id, guint length, void* data);
+
+/**
+ * Creates an empty automaton
+ *
+ * @return The automaton or NULL if an error occurred
+ */
+pdf_automaton_t* pdf_automaton_new(void);
+
+/**
+ * Frees an automaton
+ *
+ * @param automaton The automaton (may be NULL)
+ */
+void pdf_automaton_free(pdf_automaton_t* automaton);
+
+/**
+ * Adds a pattern. Patterns can only be added before the automaton is built.
+ *
+ * @param automaton The automaton
+ * @param pattern Characters of the pattern
+ * @param length Number of characters (empty patterns are ignored)
+ * @param id Identifier reported for matches of the pattern
+ */
+void pdf_automaton_add(pdf_automaton_t* automaton, const gunichar* pattern, guint length, guint id);
+
+/**
+ * Computes the failure links after all patterns have been added
+ *
+ * @param automaton The automaton
+ */
+void pdf_automaton_build(pdf_automaton_t* automaton);
+
+/**
+ * Returns the initial state
+ *
+ * @return The state
+ */
+guint pdf_automaton_start(void);
+
+/**
+ * Advances the automaton by one character
+ *
+ * @param automaton The built automaton
+ * @param state The current state
+ * @param c The next character
+ * @return The new state
+ */
+guint pdf_automaton_next(const pdf_automaton_t* automaton, guint state, gunichar c);
+
+/**
+ * Reports all patterns that end in the given state
+ *
+ * @param automaton The built automaton
+ * @param state The current state
+ * @param func Function called for every pattern
+ * @param data User data passed to func
+ * @return false if func stopped the reporting
+ */
+bool pdf_automaton_foreach_match(const pdf_automaton_t* automaton, guint state, pdf_automaton_match_func_t func,
+                                 void* data);
+
+#endif // AUTOMATON_H
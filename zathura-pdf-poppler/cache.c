@@ -0,0 +1,116 @@
+/* SPDX-License-Identifier: Zlib */
+
+#include "cache.h"
+
+typedef struct cache_entry_s {
+  GBytes* key;
+  cairo_surface_t* surface;
+  gsize size;
+  GList link;
+} cache_entry_t;
+
+struct pdf_cache_s {
+  GHashTable* entries;
+  GQueue lru;
+  gsize size;
+  gsize budget;
+  GMutex lock;
+};
+
+static void cache_entry_free(void* data) {
+  cache_entry_t* entry = data;
+  cairo_surface_destroy(entry->surface);
+  g_bytes_unref(entry->key);
+  g_free(entry);
+}
+
+pdf_cache_t* pdf_cache_new(gsize budget) {
+  if (budget == 0) {
+    return NULL;
+  }
+
+  pdf_cache_t* cache = g_try_malloc0(sizeof(pdf_cache_t));
+  if (cache == NULL) {
+    return NULL;
+  }
+
+  cache->entries = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, NULL, cache_entry_free);
+  cache->budget  = budget;
+  g_queue_init(&cache->lru);
+  g_mutex_init(&cache->lock);
+
+  return cache;
+}
+
+void pdf_cache_free(pdf_cache_t* cache) {
+  if (cache == NULL) {
+    return;
+  }
+
+  g_hash_table_unref(cache->entries);
+  g_mutex_clear(&cache->lock);
+  g_free(cache);
+}
+
+cairo_surface_t* pdf_cache_lookup(pdf_cache_t* cache, const void* key, gsize key_size) {
+  if (cache == NULL || key == NULL) {
+    return NULL;
+  }
+
+  GBytes* lookup_key       = g_bytes_new_static(key, key_size);
+  cairo_surface_t* surface = NULL;
+
+  g_mutex_lock(&cache->lock);
+  cache_entry_t* entry = g_hash_table_lookup(cache->entries, lookup_key);
+  if (entry != NULL) {
+    g_queue_unlink(&cache->lru, &entry->link);
+    g_queue_push_head_link(&cache->lru, &entry->link);
+    surface = cairo_surface_reference(entry->surface);
+  }
+  g_mutex_unlock(&cache->lock);
+
+  g_bytes_unref(lookup_key);
+  return surface;
+}
+
+static void cache_remove(pdf_cache_t* cache, cache_entry_t* entry) {
+  g_queue_unlink(&cache->lru, &entry->link);
+  cache->size -= entry->size;
+  g_hash_table_remove(cache->entries, entry->key);
+}
+
+void pdf_cache_insert(pdf_cache_t* cache, const void* key, gsize key_size, cairo_surface_t* surface) {
+  if (cache == NULL || key == NULL || surface == NULL) {
+    return;
+  }
+
+  const gsize size = (gsize)cairo_image_surface_get_stride(surface) * cairo_image_surface_get_height(surface);
+  if (size > cache->budget) {
+    return;
+  }
+
+  cache_entry_t* entry = g_try_malloc0(sizeof(cache_entry_t));
+  if (entry == NULL) {
+    return;
+  }
+
+  entry->key       = g_bytes_new(key, key_size);
+  entry->surface   = cairo_surface_reference(surface);
+  entry->size      = size;
+  entry->link.data = entry;
+
+  g_mutex_lock(&cache->lock);
+  cache_entry_t* existing = g_hash_table_lookup(cache->entries, entry->key);
+  if (existing != NULL) {
+    cache_remove(cache, existing);
+  }
+
+  while (cache->size + size > cache->budget && cache->lru.tail != NULL) {
+    cache_remove(cache, cache->lru.tail->data);
+  }
+
+  g_hash_table_insert(cache->entries, entry->key, entry);
+  g_queue_push_head_link(&cache->lru, &entry->link);
+  cache->size += size;
+  g_mutex_unlock(&cache->lock);
+}
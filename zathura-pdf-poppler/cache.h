@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: Zlib */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "plugin.h"
+
+/**
+ * Environment variable with the budget of the render cache in MiB
+ */
+#define PDF_RENDER_CACHE_ENV "ZATHURA_PDF_POPPLER_RENDER_CACHE"
+
+/**
+ * Default budget of the render cache in MiB
+ */
+#define PDF_RENDER_CACHE_DEFAULT 64
+
+/**
+ * Environment variable with the budget of the thumbnail cache in MiB
+ */
+#define PDF_THUMBNAIL_CACHE_ENV "ZATHURA_PDF_POPPLER_THUMBNAIL_CACHE"
+
+/**
+ * Default budget of the thumbnail cache in MiB
+ */
+#define PDF_THUMBNAIL_CACHE_DEFAULT 16
+
+/**
+ * Environment variable with the budget of the decoded image cache in MiB
+ */
+#define PDF_IMAGE_CACHE_ENV "ZATHURA_PDF_POPPLER_IMAGE_CACHE"
+
+/**
+ * Default budget of the decoded image cache in MiB. A decoded 40 megapixel
+ * photo takes about 153 MiB, images larger than the budget are never cached.
+ */
+#define PDF_IMAGE_CACHE_DEFAULT 256
+
+/**
+ * Byte-budgeted LRU cache of cairo image surfaces. Keys are arbitrary byte
+ * strings (usually zero-initialized structs).
+ */
+typedef struct pdf_cache_s pdf_cache_t;
+
+/**
+ * Creates a new cache
+ *
+ * @param budget Maximal number of bytes of all cached surfaces
+ * @return The cache or NULL if budget is 0
+ */
+pdf_cache_t* pdf_cache_new(gsize budget);
+
+/**
+ * Frees the cache and releases all cached surfaces
+ *
+ * @param cache The cache
+ */
+void pdf_cache_free(pdf_cache_t* cache);
+
+/**
+ * Looks up a surface and marks it as most recently used
+ *
+ * @param cache The cache
+ * @param key The key
+ * @param key_size Size of the key in bytes
+ * @return New reference to the cached surface or NULL if none is cached
+ */
+cairo_surface_t* pdf_cache_lookup(pdf_cache_t* cache, const void* key, gsize key_size);
+
+/**
+ * Inserts a surface, replacing an existing entry with the same key, and
+ * evicts least recently used surfaces until the cache fits its budget
+ *
+ * @param cache The cache
+ * @param key The key
+ * @param key_size Size of the key in bytes
+ * @param surface The image surface (the cache takes its own reference)
+ */
+void pdf_cache_insert(pdf_cache_t* cache, const void* key, gsize key_size, cairo_surface_t* surface);
+
+#endif // CACHE_H
@@ -1,55 +1,103 @@
 /* SPDX-License-Identifier: Zlib */
 
 #include "plugin.h"
+#include "attachments.h"
+#include "cache.h"
+#include "fulltext.h"
+#include "index.h"
+#include "page.h"
+#include "pool.h"
+#include "prefetch.h"
+#include "signature.h"
+#include "text.h"
+#include "trace.h"
 #include "utils.h"
 
+static void pdf_document_clear(pdf_document_t* pdf_document) {
+  pdf_trace_free(pdf_document->trace);
+  pdf_cache_free(pdf_document->render_cache);
+  pdf_cache_free(pdf_document->thumbnail_cache);
+  pdf_cache_free(pdf_document->image_cache);
+  pdf_fulltext_free(pdf_document->fulltext);
+  pdf_signatures_free(pdf_document->signatures);
+  pdf_prefetch_free(pdf_document->prefetch);
+  pdf_document_pool_clear(pdf_document);
+  pdf_document_lru_clear(pdf_document);
+  pdf_document_text_lru_clear(pdf_document);
+  pdf_document_outline_clear(pdf_document);
+  pdf_document_destinations_clear(pdf_document);
+  pdf_document_attachments_clear(pdf_document);
+  g_free(pdf_document->geometry);
+  if (pdf_document->document != NULL) {
+    g_object_unref(pdf_document->document);
+  }
+  if (pdf_document->mapping != NULL) {
+    g_mapped_file_unref(pdf_document->mapping);
+  }
+  g_free(pdf_document->path);
+  g_free(pdf_document->password);
+  g_free(pdf_document);
+}
+
 zathura_error_t pdf_document_open(zathura_document_t* document) {
   if (document == NULL) {
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
-  zathura_error_t error = ZATHURA_ERROR_OK;
-
-  /* format path */
-  GError* gerror = NULL;
-  char* file_uri = g_filename_to_uri(zathura_document_get_path(document), NULL, NULL);
+  pdf_document_t* pdf_document = g_try_malloc0(sizeof(pdf_document_t));
+  if (pdf_document == NULL) {
+    return ZATHURA_ERROR_OUT_OF_MEMORY;
+  }
 
-  if (file_uri == NULL) {
-    error = ZATHURA_ERROR_UNKNOWN;
-    goto error_free;
+  pdf_document->path     = g_strdup(zathura_document_get_path(document));
+  pdf_document->password = g_strdup(zathura_document_get_password(document));
+  pdf_document->trace    = pdf_trace_new();
+  pdf_document_pool_init(pdf_document);
+  pdf_document_lru_init(pdf_document);
+  pdf_document_text_lru_init(pdf_document);
+  pdf_document_destinations_init(pdf_document);
+  pdf_document_outline_init(pdf_document);
+  pdf_document_attachments_init(pdf_document);
+
+  /* map the file once and share the mapping with all poppler documents */
+  if (pdf_getenv_bool(PDF_MMAP_ENV) == true) {
+    pdf_document->mapping = g_mapped_file_new(pdf_document->path, FALSE, NULL);
   }
 
-  PopplerDocument* poppler_document =
-      poppler_document_new_from_file(file_uri, zathura_document_get_password(document), &gerror);
+  GError* gerror         = NULL;
+  pdf_document->document = pdf_document_open_poppler_document(pdf_document, &gerror);
 
-  if (poppler_document == NULL) {
+  if (pdf_document->document == NULL) {
+    zathura_error_t error = ZATHURA_ERROR_UNKNOWN;
     if (gerror != NULL && gerror->code == POPPLER_ERROR_ENCRYPTED) {
       error = ZATHURA_ERROR_INVALID_PASSWORD;
-    } else {
-      error = ZATHURA_ERROR_UNKNOWN;
     }
-    goto error_free;
-  }
 
-  zathura_document_set_data(document, poppler_document);
-
-  zathura_document_set_number_of_pages(document, poppler_document_get_n_pages(poppler_document));
-
-  g_free(file_uri);
+    g_clear_error(&gerror);
+    pdf_document_clear(pdf_document);
+    return error;
+  }
 
-  return ZATHURA_ERROR_OK;
+  pdf_document->number_of_pages = poppler_document_get_n_pages(pdf_document->document);
+  pdf_document->geometry        = g_try_malloc0_n(pdf_document->number_of_pages, sizeof(*pdf_document->geometry));
+  if (pdf_document->geometry == NULL && pdf_document->number_of_pages > 0) {
+    pdf_document_clear(pdf_document);
+    return ZATHURA_ERROR_OUT_OF_MEMORY;
+  }
 
-error_free:
+  pdf_document->fulltext     = pdf_fulltext_open(pdf_document);
+  pdf_document->render_cache = pdf_cache_new(pdf_getenv_uint(PDF_RENDER_CACHE_ENV, PDF_RENDER_CACHE_DEFAULT) << 20);
+  pdf_document->thumbnail_cache =
+      pdf_cache_new(pdf_getenv_uint(PDF_THUMBNAIL_CACHE_ENV, PDF_THUMBNAIL_CACHE_DEFAULT) << 20);
+  pdf_document->image_cache = pdf_cache_new(pdf_getenv_uint(PDF_IMAGE_CACHE_ENV, PDF_IMAGE_CACHE_DEFAULT) << 20);
+  pdf_document->signatures  = pdf_signatures_new(pdf_document);
+  pdf_document->prefetch    = pdf_prefetch_new(pdf_document, pdf_getenv_uint(PDF_PREFETCH_ENV, PDF_PREFETCH_DEFAULT));
 
-  if (gerror != NULL) {
-    g_error_free(gerror);
-  }
+  zathura_document_set_data(document, pdf_document);
 
-  if (file_uri != NULL) {
-    g_free(file_uri);
-  }
+  zathura_document_set_number_of_pages(document, pdf_document->number_of_pages);
 
-  return error;
+  return ZATHURA_ERROR_OK;
 }
 
 zathura_error_t pdf_document_free(zathura_document_t* document, void* data) {
@@ -57,9 +105,9 @@ zathura_error_t pdf_document_free(zathura_document_t* document, void* data) {
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
-  PopplerDocument* poppler_document = data;
-  if (poppler_document != NULL) {
-    g_object_unref(poppler_document);
+  pdf_document_t* pdf_document = data;
+  if (pdf_document != NULL) {
+    pdf_document_clear(pdf_document);
     zathura_document_set_data(document, NULL);
   }
 
@@ -77,9 +125,9 @@ zathura_error_t pdf_document_save_as(zathura_document_t* document, void* data, c
     return ZATHURA_ERROR_UNKNOWN;
   }
 
-  PopplerDocument* poppler_document = data;
+  pdf_document_t* pdf_document = data;
 
-  const gboolean ret = poppler_document_save(poppler_document, file_uri, NULL);
+  const gboolean ret = poppler_document_save(pdf_document->document, file_uri, NULL);
   g_free(file_uri);
 
   return (ret == TRUE ? ZATHURA_ERROR_OK : ZATHURA_ERROR_UNKNOWN);
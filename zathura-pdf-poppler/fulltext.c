@@ -0,0 +1,646 @@
+/* SPDX-License-Identifier: Zlib */
+
+#include <string.h>
+#include <glib/gstdio.h>
+#include <girara/log.h>
+
+#include "fulltext.h"
+#include "pool.h"
+#include "text.h"
+#include "utils.h"
+
+#define FULLTEXT_MAGIC "ZPPFTI02"
+#define FULLTEXT_KEY_LENGTH 64
+#define FULLTEXT_SAMPLE_SIZE (64 * 1024)
+#define FULLTEXT_MAX_TERM_LENGTH 128
+/* Longest query token that is guaranteed to lie within one window of a long term */
+#define FULLTEXT_MAX_TOKEN_LENGTH (FULLTEXT_MAX_TERM_LENGTH / 2 - 4)
+/* Number of queries whose candidate pages are kept */
+#define FULLTEXT_MAX_QUERIES 16
+
+/* On-disk layout: header, term table sorted by term, postings (page indices), trigram table sorted by trigram,
+ * trigram postings (term indices), term strings */
+typedef struct fulltext_header_s {
+  char magic[8];
+  guint32 n_pages;
+  guint32 n_terms;
+  guint32 n_postings;
+  guint32 n_grams;
+  guint32 n_gram_postings;
+  guint32 reserved;
+  guint64 file_size;
+  gint64 mtime;
+  char key[FULLTEXT_KEY_LENGTH];
+} fulltext_header_t;
+
+typedef struct fulltext_term_s {
+  guint32 offset;     /* offset of the term in the string table */
+  guint32 length;     /* length of the term in bytes */
+  guint32 postings;   /* index of the first posting */
+  guint32 n_postings; /* number of pages containing the term */
+} fulltext_term_t;
+
+typedef struct fulltext_gram_s {
+  guint32 gram;    /* three consecutive bytes of a term */
+  guint32 terms;   /* index of the first trigram posting */
+  guint32 n_terms; /* number of terms containing the trigram */
+} fulltext_gram_t;
+
+struct pdf_fulltext_s {
+  pdf_document_t* pdf_document;
+  char* path;
+  char key[FULLTEXT_KEY_LENGTH];
+  guint64 file_size;
+  gint64 mtime;
+
+  GThread* builder;
+  gint cancelled;
+
+  GMutex lock;
+  GMappedFile* file;
+  const fulltext_header_t* header;
+  const fulltext_term_t* terms;
+  const guint32* postings;
+  const fulltext_gram_t* grams;
+  const guint32* gram_postings;
+  const char* strings;
+
+  GHashTable* queries; /* candidate pages of recent queries (NULL if no page can be ruled out) */
+  GQueue query_order;  /* queries, least recently used first */
+};
+
+static bool fulltext_compute_key(pdf_fulltext_t* fulltext, pdf_document_t* pdf_document) {
+  GStatBuf st;
+  if (g_stat(pdf_document->path, &st) != 0) {
+    return false;
+  }
+
+  GMappedFile* mapped = pdf_document->mapping != NULL ? g_mapped_file_ref(pdf_document->mapping)
+                                                      : g_mapped_file_new(pdf_document->path, FALSE, NULL);
+  if (mapped == NULL) {
+    return false;
+  }
+
+  fulltext->file_size = st.st_size;
+  fulltext->mtime     = st.st_mtime;
+
+  GChecksum* checksum = g_checksum_new(G_CHECKSUM_SHA256);
+  char* metadata =
+      g_strdup_printf("%" G_GUINT64_FORMAT ":%" G_GINT64_FORMAT, fulltext->file_size, fulltext->mtime);
+  g_checksum_update(checksum, (const guchar*)metadata, -1);
+  g_free(metadata);
+
+  /* hashing multi-GB files on every open is too slow, sample the head, middle and tail (trailer and xref) */
+  const guchar* contents = (const guchar*)g_mapped_file_get_contents(mapped);
+  const gsize length     = g_mapped_file_get_length(mapped);
+  if (contents != NULL && length > 0) {
+    const gsize sample    = MIN(length, FULLTEXT_SAMPLE_SIZE);
+    const gsize offsets[] = {0, (length - sample) / 2, length - sample};
+    for (unsigned int i = 0; i < G_N_ELEMENTS(offsets); ++i) {
+      g_checksum_update(checksum, contents + offsets[i], sample);
+    }
+  }
+
+  memcpy(fulltext->key, g_checksum_get_string(checksum), FULLTEXT_KEY_LENGTH);
+  g_checksum_free(checksum);
+  g_mapped_file_unref(mapped);
+
+  return true;
+}
+
+static bool fulltext_load(pdf_fulltext_t* fulltext) {
+  GMappedFile* file = g_mapped_file_new(fulltext->path, FALSE, NULL);
+  if (file == NULL) {
+    return false;
+  }
+
+  const char* data = g_mapped_file_get_contents(file);
+  const gsize size = g_mapped_file_get_length(file);
+  if (data == NULL || size < sizeof(fulltext_header_t)) {
+    goto error_free;
+  }
+
+  const fulltext_header_t* header = (const fulltext_header_t*)data;
+  if (memcmp(header->magic, FULLTEXT_MAGIC, sizeof(header->magic)) != 0 ||
+      header->file_size != fulltext->file_size || header->mtime != fulltext->mtime ||
+      memcmp(header->key, fulltext->key, FULLTEXT_KEY_LENGTH) != 0) {
+    goto error_free;
+  }
+
+  const gsize tables_size = (gsize)header->n_terms * sizeof(fulltext_term_t) +
+                            (gsize)header->n_postings * sizeof(guint32) +
+                            (gsize)header->n_grams * sizeof(fulltext_gram_t) +
+                            (gsize)header->n_gram_postings * sizeof(guint32);
+  if (tables_size > size - sizeof(fulltext_header_t)) {
+    goto error_free;
+  }
+
+  const fulltext_term_t* terms = (const fulltext_term_t*)(data + sizeof(fulltext_header_t));
+  const guint32* postings      = (const guint32*)(terms + header->n_terms);
+  const fulltext_gram_t* grams = (const fulltext_gram_t*)(postings + header->n_postings);
+  const guint32* gram_postings = (const guint32*)(grams + header->n_grams);
+  const char* strings          = (const char*)(gram_postings + header->n_gram_postings);
+  const gsize strings_size     = size - sizeof(fulltext_header_t) - tables_size;
+
+  for (guint32 i = 0; i < header->n_terms; ++i) {
+    if ((gsize)terms[i].offset + terms[i].length > strings_size ||
+        (gsize)terms[i].postings + terms[i].n_postings > header->n_postings) {
+      goto error_free;
+    }
+  }
+
+  for (guint32 i = 0; i < header->n_grams; ++i) {
+    if ((gsize)grams[i].terms + grams[i].n_terms > header->n_gram_postings) {
+      goto error_free;
+    }
+  }
+
+  for (guint32 i = 0; i < header->n_gram_postings; ++i) {
+    if (gram_postings[i] >= header->n_terms) {
+      goto error_free;
+    }
+  }
+
+  g_mutex_lock(&fulltext->lock);
+  fulltext->file          = file;
+  fulltext->header        = header;
+  fulltext->terms         = terms;
+  fulltext->postings      = postings;
+  fulltext->grams         = grams;
+  fulltext->gram_postings = gram_postings;
+  fulltext->strings       = strings;
+  g_mutex_unlock(&fulltext->lock);
+
+  return true;
+
+error_free:
+  g_mapped_file_unref(file);
+  return false;
+}
+
+static void fulltext_add_term(GHashTable* terms, const char* term, guint32 page) {
+  GArray* pages = g_hash_table_lookup(terms, term);
+  if (pages == NULL) {
+    pages = g_array_new(FALSE, FALSE, sizeof(guint32));
+    g_hash_table_insert(terms, g_strdup(term), pages);
+  }
+
+  if (pages->len == 0 || g_array_index(pages, guint32, pages->len - 1) != page) {
+    g_array_append_val(pages, page);
+  }
+}
+
+/* Returns the start of the UTF-8 character that contains the byte at offset */
+static gsize utf8_boundary(const char* text, gsize offset) {
+  while (offset > 0 && ((guchar)text[offset] & 0xc0) == 0x80) {
+    --offset;
+  }
+
+  return offset;
+}
+
+/*
+ * Terms longer than FULLTEXT_MAX_TERM_LENGTH are indexed as windows that overlap by half of their length, so that
+ * every part of the term of up to FULLTEXT_MAX_TOKEN_LENGTH bytes lies within one of them. Queries only look for
+ * prefixes of that length, hence a long term can never be missed.
+ */
+static void fulltext_add_long_term(GHashTable* terms, const GString* term, guint32 page) {
+  if (term->len <= FULLTEXT_MAX_TERM_LENGTH) {
+    fulltext_add_term(terms, term->str, page);
+    return;
+  }
+
+  for (gsize start = 0;; start = utf8_boundary(term->str, start + FULLTEXT_MAX_TERM_LENGTH / 2)) {
+    const gsize end = start + FULLTEXT_MAX_TERM_LENGTH >= term->len
+                          ? term->len
+                          : utf8_boundary(term->str, start + FULLTEXT_MAX_TERM_LENGTH);
+
+    char* window = g_strndup(term->str + start, end - start);
+    fulltext_add_term(terms, window, page);
+    g_free(window);
+
+    if (end == term->len) {
+      break;
+    }
+  }
+}
+
+static guint32 fulltext_gram(const char* term) {
+  return ((guint32)(guchar)term[0] << 16) | ((guint32)(guchar)term[1] << 8) | (guchar)term[2];
+}
+
+static int compare_terms(const void* a, const void* b) {
+  return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+static gint compare_gram_pairs(gconstpointer a, gconstpointer b) {
+  const guint64 lhs = *(const guint64*)a;
+  const guint64 rhs = *(const guint64*)b;
+
+  return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+}
+
+static bool fulltext_write(pdf_fulltext_t* fulltext, GHashTable* terms, guint32 n_pages) {
+  GPtrArray* keys = g_hash_table_get_keys_as_ptr_array(terms);
+  g_ptr_array_sort(keys, compare_terms);
+
+  gsize n_postings   = 0;
+  gsize strings_size = 0;
+  for (guint i = 0; i < keys->len; ++i) {
+    const GArray* pages = g_hash_table_lookup(terms, g_ptr_array_index(keys, i));
+    n_postings += pages->len;
+    strings_size += strlen(g_ptr_array_index(keys, i));
+  }
+
+  /* every trigram of every term as (trigram << 32 | term index), sorting groups the terms of a trigram */
+  GArray* pairs = g_array_new(FALSE, FALSE, sizeof(guint64));
+  for (guint i = 0; i < keys->len; ++i) {
+    const char* term = g_ptr_array_index(keys, i);
+    for (gsize j = 0; term[j] != '\0' && term[j + 1] != '\0' && term[j + 2] != '\0'; ++j) {
+      const guint64 pair = ((guint64)fulltext_gram(term + j) << 32) | i;
+      g_array_append_val(pairs, pair);
+    }
+  }
+  g_array_sort(pairs, compare_gram_pairs);
+
+  /* a term may contain a trigram more than once */
+  gsize n_grams         = 0;
+  gsize n_gram_postings = 0;
+  for (guint i = 0; i < pairs->len; ++i) {
+    const guint64 pair = g_array_index(pairs, guint64, i);
+    if (i > 0 && g_array_index(pairs, guint64, i - 1) == pair) {
+      continue;
+    }
+    if (i == 0 || g_array_index(pairs, guint64, i - 1) >> 32 != pair >> 32) {
+      n_grams++;
+    }
+    n_gram_postings++;
+  }
+
+  if (n_postings > G_MAXUINT32 || strings_size > G_MAXUINT32 || n_gram_postings > G_MAXUINT32) {
+    g_array_unref(pairs);
+    g_ptr_array_unref(keys);
+    return false;
+  }
+
+  const gsize size = sizeof(fulltext_header_t) + keys->len * sizeof(fulltext_term_t) + n_postings * sizeof(guint32) +
+                     n_grams * sizeof(fulltext_gram_t) + n_gram_postings * sizeof(guint32) + strings_size;
+  char* data = g_try_malloc0(size);
+  if (data == NULL) {
+    g_array_unref(pairs);
+    g_ptr_array_unref(keys);
+    return false;
+  }
+
+  fulltext_header_t* header = (fulltext_header_t*)data;
+  memcpy(header->magic, FULLTEXT_MAGIC, sizeof(header->magic));
+  header->n_pages         = n_pages;
+  header->n_terms         = keys->len;
+  header->n_postings      = n_postings;
+  header->n_grams         = n_grams;
+  header->n_gram_postings = n_gram_postings;
+  header->file_size       = fulltext->file_size;
+  header->mtime           = fulltext->mtime;
+  memcpy(header->key, fulltext->key, FULLTEXT_KEY_LENGTH);
+
+  fulltext_term_t* term_table = (fulltext_term_t*)(data + sizeof(fulltext_header_t));
+  guint32* postings           = (guint32*)(term_table + keys->len);
+  fulltext_gram_t* gram_table = (fulltext_gram_t*)(postings + n_postings);
+  guint32* gram_postings      = (guint32*)(gram_table + n_grams);
+  char* strings               = (char*)(gram_postings + n_gram_postings);
+
+  guint32 posting_offset = 0;
+  guint32 string_offset  = 0;
+  for (guint i = 0; i < keys->len; ++i) {
+    const char* term    = g_ptr_array_index(keys, i);
+    const GArray* pages = g_hash_table_lookup(terms, term);
+    const gsize length  = strlen(term);
+
+    term_table[i].offset     = string_offset;
+    term_table[i].length     = length;
+    term_table[i].postings   = posting_offset;
+    term_table[i].n_postings = pages->len;
+
+    memcpy(strings + string_offset, term, length);
+    memcpy(postings + posting_offset, pages->data, pages->len * sizeof(guint32));
+    string_offset += length;
+    posting_offset += pages->len;
+  }
+  g_ptr_array_unref(keys);
+
+  guint32 gram         = 0;
+  guint32 gram_posting = 0;
+  for (guint i = 0; i < pairs->len; ++i) {
+    const guint64 pair = g_array_index(pairs, guint64, i);
+    if (i > 0 && g_array_index(pairs, guint64, i - 1) == pair) {
+      continue;
+    }
+
+    if (gram == 0 || gram_table[gram - 1].gram != pair >> 32) {
+      gram_table[gram].gram  = pair >> 32;
+      gram_table[gram].terms = gram_posting;
+      gram++;
+    }
+    gram_table[gram - 1].n_terms++;
+    gram_postings[gram_posting++] = (guint32)pair;
+  }
+  g_array_unref(pairs);
+
+  char* directory = g_path_get_dirname(fulltext->path);
+  g_mkdir_with_parents(directory, 0700);
+  g_free(directory);
+
+  GError* gerror   = NULL;
+  const bool saved = g_file_set_contents(fulltext->path, data, size, &gerror);
+  if (saved == false) {
+    girara_warning("Failed to write search index '%s': %s", fulltext->path, gerror->message);
+    g_error_free(gerror);
+  }
+
+  g_free(data);
+  return saved;
+}
+
+static gpointer fulltext_build(gpointer data) {
+  pdf_fulltext_t* fulltext = data;
+
+  const unsigned int n_pages = fulltext->pdf_document->number_of_pages;
+  GHashTable* terms          = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_array_unref);
+  GString* term              = g_string_sized_new(32);
+  bool complete              = true;
+
+  for (unsigned int page = 0; page < n_pages; ++page) {
+    if (g_atomic_int_get(&fulltext->cancelled) != 0) {
+      complete = false;
+      break;
+    }
+
+    /* the document is only held for one page, so that searches do not wait for the whole build */
+    PopplerDocument* poppler_document = pdf_document_pool_acquire(fulltext->pdf_document);
+    if (poppler_document == NULL) {
+      complete = false;
+      break;
+    }
+
+    /* the text layout is only needed for tokenizing, do not keep it in the page cache */
+    PopplerPage* poppler_page = poppler_document_get_page(poppler_document, page);
+    pdf_text_t* text          = pdf_text_new(poppler_page);
+    if (poppler_page != NULL) {
+      g_object_unref(poppler_page);
+    }
+    pdf_document_pool_release(fulltext->pdf_document, poppler_document);
+    if (text == NULL) {
+      continue;
+    }
+
+    for (guint i = 0; i <= text->length; ++i) {
+      const gunichar c = i < text->length ? text->characters[i] : 0;
+      if (c != 0 && g_unichar_isalnum(c) == TRUE) {
+        char buffer[6];
+        g_string_append_len(term, buffer, g_unichar_to_utf8(c, buffer));
+        continue;
+      }
+
+      if (term->len > 0) {
+        fulltext_add_long_term(terms, term, page);
+        g_string_truncate(term, 0);
+      }
+    }
+
+    pdf_text_unref(text);
+  }
+
+  if (complete == true && fulltext_write(fulltext, terms, n_pages) == true) {
+    fulltext_load(fulltext);
+  }
+
+  g_string_free(term, TRUE);
+  g_hash_table_unref(terms);
+
+  return NULL;
+}
+
+pdf_fulltext_t* pdf_fulltext_open(pdf_document_t* pdf_document) {
+  if (pdf_document == NULL || pdf_getenv_bool(PDF_FULLTEXT_ENV) == false) {
+    return NULL;
+  }
+
+  /* the index contains the text of the document, it must not leak the content of protected files */
+  if (pdf_document->password != NULL && pdf_document->password[0] != '\0') {
+    return NULL;
+  }
+
+  pdf_fulltext_t* fulltext = g_try_malloc0(sizeof(pdf_fulltext_t));
+  if (fulltext == NULL) {
+    return NULL;
+  }
+
+  fulltext->pdf_document = pdf_document;
+  fulltext->queries      = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+  g_queue_init(&fulltext->query_order);
+  g_mutex_init(&fulltext->lock);
+
+  if (fulltext_compute_key(fulltext, pdf_document) == false) {
+    pdf_fulltext_free(fulltext);
+    return NULL;
+  }
+
+  char* filename = g_strdup_printf("%.*s.index", FULLTEXT_KEY_LENGTH, fulltext->key);
+  fulltext->path = g_build_filename(g_get_user_cache_dir(), "zathura-pdf-poppler", filename, NULL);
+  g_free(filename);
+
+  if (fulltext_load(fulltext) == false) {
+    fulltext->builder = g_thread_try_new("pdf-fulltext", fulltext_build, fulltext, NULL);
+  }
+
+  return fulltext;
+}
+
+void pdf_fulltext_free(pdf_fulltext_t* fulltext) {
+  if (fulltext == NULL) {
+    return;
+  }
+
+  if (fulltext->builder != NULL) {
+    g_atomic_int_set(&fulltext->cancelled, 1);
+    g_thread_join(fulltext->builder);
+  }
+
+  if (fulltext->file != NULL) {
+    g_mapped_file_unref(fulltext->file);
+  }
+
+  g_mutex_clear(&fulltext->lock);
+  g_queue_clear(&fulltext->query_order);
+  g_hash_table_unref(fulltext->queries);
+  g_free(fulltext->path);
+  g_free(fulltext);
+}
+
+static bool term_contains(const char* term, gsize term_length, const char* token, gsize token_length) {
+  for (gsize i = 0; i + token_length <= term_length; ++i) {
+    if (memcmp(term + i, token, token_length) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static GPtrArray* fulltext_tokenize(const char* text) {
+  GPtrArray* tokens = g_ptr_array_new_with_free_func(g_free);
+  GString* token    = g_string_new(NULL);
+
+  for (const char* p = text;; p = g_utf8_next_char(p)) {
+    const gunichar c = g_utf8_get_char(p);
+    if (c != 0 && g_unichar_isalnum(c) == TRUE) {
+      char buffer[6];
+      g_string_append_len(token, buffer, g_unichar_to_utf8(g_unichar_tolower(c), buffer));
+    } else if (token->len > 0) {
+      g_ptr_array_add(tokens, g_strdup(token->str));
+      g_string_truncate(token, 0);
+    }
+
+    if (c == 0) {
+      break;
+    }
+  }
+
+  g_string_free(token, TRUE);
+  return tokens;
+}
+
+/* Finds the entry of a trigram with a binary search, NULL if no term contains the trigram */
+static const fulltext_gram_t* fulltext_find_gram(pdf_fulltext_t* fulltext, guint32 gram) {
+  guint32 low  = 0;
+  guint32 high = fulltext->header->n_grams;
+  while (low < high) {
+    const guint32 middle = low + (high - low) / 2;
+    if (fulltext->grams[middle].gram == gram) {
+      return &fulltext->grams[middle];
+    }
+    if (fulltext->grams[middle].gram < gram) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  return NULL;
+}
+
+/* Marks the pages of all terms that contain a token of at least three bytes */
+static void fulltext_lookup_token(pdf_fulltext_t* fulltext, const char* token, gsize token_length,
+                                  guint8* candidates) {
+  /* only the terms of the rarest trigram of the token can contain it */
+  const fulltext_gram_t* rarest = NULL;
+  for (gsize i = 0; i + 2 < token_length; ++i) {
+    const fulltext_gram_t* gram = fulltext_find_gram(fulltext, fulltext_gram(token + i));
+    if (gram == NULL) {
+      return;
+    }
+    if (rarest == NULL || gram->n_terms < rarest->n_terms) {
+      rarest = gram;
+    }
+  }
+
+  const guint32 n_pages = fulltext->header->n_pages;
+  for (guint32 n = 0; n < rarest->n_terms; ++n) {
+    const fulltext_term_t* term = &fulltext->terms[fulltext->gram_postings[rarest->terms + n]];
+    if (term_contains(fulltext->strings + term->offset, term->length, token, token_length) == false) {
+      continue;
+    }
+
+    for (guint32 i = 0; i < term->n_postings; ++i) {
+      const guint32 page = fulltext->postings[term->postings + i];
+      if (page < n_pages) {
+        candidates[page / 8] |= 1 << (page % 8);
+      }
+    }
+  }
+}
+
+/* Computes a bitmap of the pages on which every token of the query is part of an indexed term. */
+static guint8* fulltext_lookup(pdf_fulltext_t* fulltext, const char* text) {
+  GPtrArray* tokens = fulltext_tokenize(text);
+  if (tokens->len == 0) {
+    g_ptr_array_unref(tokens);
+    return NULL;
+  }
+
+  const guint32 n_pages    = fulltext->header->n_pages;
+  const gsize bitmap_size  = n_pages / 8 + 1;
+  guint8* candidates       = g_malloc(bitmap_size);
+  guint8* token_candidates = g_malloc(bitmap_size);
+  memset(candidates, 0xff, bitmap_size);
+
+  for (guint t = 0; t < tokens->len; ++t) {
+    const char* token  = g_ptr_array_index(tokens, t);
+    gsize token_length = strlen(token);
+    /* long terms are indexed in windows, only a prefix of a long token is guaranteed to be in one of them */
+    if (token_length > FULLTEXT_MAX_TOKEN_LENGTH) {
+      token_length = utf8_boundary(token, FULLTEXT_MAX_TOKEN_LENGTH);
+    }
+
+    /* tokens without a trigram are part of too many terms to rule out any page */
+    if (token_length < 3) {
+      continue;
+    }
+
+    memset(token_candidates, 0, bitmap_size);
+    fulltext_lookup_token(fulltext, token, token_length, token_candidates);
+
+    for (gsize i = 0; i < bitmap_size; ++i) {
+      candidates[i] &= token_candidates[i];
+    }
+  }
+
+  g_free(token_candidates);
+  g_ptr_array_unref(tokens);
+  return candidates;
+}
+
+/*
+ * Returns the candidate pages of a query. They are computed once per query and kept for the most recent ones, so that
+ * searches for several terms or several concurrent searches do not recompute them for every page. Needs to be called
+ * with the lock held.
+ */
+static const guint8* fulltext_query_candidates(pdf_fulltext_t* fulltext, const char* text) {
+  char* query        = NULL;
+  guint8* candidates = NULL;
+  if (g_hash_table_lookup_extended(fulltext->queries, text, (gpointer*)&query, (gpointer*)&candidates) == TRUE) {
+    g_queue_remove(&fulltext->query_order, query);
+    g_queue_push_tail(&fulltext->query_order, query);
+    return candidates;
+  }
+
+  if (g_queue_get_length(&fulltext->query_order) >= FULLTEXT_MAX_QUERIES) {
+    g_hash_table_remove(fulltext->queries, g_queue_pop_head(&fulltext->query_order));
+  }
+
+  query      = g_strdup(text);
+  candidates = fulltext_lookup(fulltext, text);
+  g_hash_table_insert(fulltext->queries, query, candidates);
+  g_queue_push_tail(&fulltext->query_order, query);
+
+  return candidates;
+}
+
+bool pdf_fulltext_page_may_match(pdf_fulltext_t* fulltext, const char* text, unsigned int page) {
+  if (fulltext == NULL || text == NULL) {
+    return true;
+  }
+
+  bool result = true;
+
+  g_mutex_lock(&fulltext->lock);
+  if (fulltext->header != NULL && page < fulltext->header->n_pages) {
+    const guint8* candidates = fulltext_query_candidates(fulltext, text);
+    if (candidates != NULL) {
+      result = (candidates[page / 8] & (1 << (page % 8))) != 0;
+    }
+  }
+  g_mutex_unlock(&fulltext->lock);
+
+  return result;
+}
@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: Zlib */
+
+#ifndef FULLTEXT_H
+#define FULLTEXT_H
+
+#include "plugin.h"
+
+/**
+ * Environment variable that enables the persistent full-text index
+ */
+#define PDF_FULLTEXT_ENV "ZATHURA_PDF_POPPLER_SEARCH_INDEX"
+
+typedef struct pdf_fulltext_s pdf_fulltext_t;
+
+/**
+ * Opens the persistent full-text index of a document. The index is stored in
+ * the user's cache directory and keyed by file size, modification time and a
+ * hash of the file content. If no valid index exists, it is built in the
+ * background and becomes available once it has been written.
+ *
+ * @param pdf_document The document
+ * @return Full-text index or NULL if the index is disabled
+ */
+pdf_fulltext_t* pdf_fulltext_open(pdf_document_t* pdf_document);
+
+/**
+ * Stops a running index build and frees the full-text index
+ *
+ * @param fulltext The full-text index
+ */
+void pdf_fulltext_free(pdf_fulltext_t* fulltext);
+
+/**
+ * Checks whether a page might contain the search text. Pages for which this
+ * function returns false are guaranteed to have no match.
+ *
+ * @param fulltext The full-text index
+ * @param text Search item
+ * @param page Page index
+ * @return false if the page has no match, true if it might have one or the
+ *   index is not available
+ */
+bool pdf_fulltext_page_may_match(pdf_fulltext_t* fulltext, const char* text, unsigned int page);
+
+#endif // FULLTEXT_H
@@ -1,8 +1,25 @@
 /* SPDX-License-Identifier: Zlib */
 
+#include <math.h>
+#include <string.h>
+
 #include "plugin.h"
+#include "cache.h"
+#include "page.h"
 #include "utils.h"
 
+/* Cached entry of the image mapping of a page */
+typedef struct pdf_image_s {
+  gint id;                      /* Image id */
+  zathura_rectangle_t position; /* Position of the image */
+} pdf_image_t;
+
+/* Key of the decoded image cache */
+typedef struct image_key_s {
+  unsigned int page;
+  gint id;
+} image_key_t;
+
 static void pdf_zathura_image_free(void* data) {
   zathura_image_t* image = data;
   if (image != NULL) {
@@ -11,18 +28,65 @@ static void pdf_zathura_image_free(void* data) {
   g_free(image);
 }
 
+static GArray* pdf_page_get_image_mapping(pdf_page_t* pdf_page) {
+  g_mutex_lock(&pdf_page->lock);
+  GArray* images = pdf_page->images != NULL ? g_array_ref(pdf_page->images) : NULL;
+  g_mutex_unlock(&pdf_page->lock);
+
+  if (images != NULL) {
+    return images;
+  }
+
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+  if (poppler_page == NULL) {
+    return NULL;
+  }
+
+  GList* image_mapping = poppler_page_get_image_mapping(poppler_page);
+  g_object_unref(poppler_page);
+
+  images = g_array_new(FALSE, FALSE, sizeof(pdf_image_t));
+  for (GList* image = image_mapping; image != NULL; image = g_list_next(image)) {
+    PopplerImageMapping* poppler_image = (PopplerImageMapping*)image->data;
+
+    pdf_image_t pdf_image = {
+        .id       = poppler_image->image_id,
+        .position = {
+            .x1 = poppler_image->area.x1,
+            .x2 = poppler_image->area.x2,
+            .y1 = poppler_image->area.y1,
+            .y2 = poppler_image->area.y2,
+        },
+    };
+    g_array_append_val(images, pdf_image);
+  }
+
+  if (image_mapping != NULL) {
+    poppler_page_free_image_mapping(image_mapping);
+  }
+
+  /* another thread might have been faster */
+  g_mutex_lock(&pdf_page->lock);
+  if (pdf_page->images == NULL) {
+    pdf_page->images = g_array_ref(images);
+  } else {
+    g_array_unref(images);
+    images = g_array_ref(pdf_page->images);
+  }
+  g_mutex_unlock(&pdf_page->lock);
+
+  return images;
+}
+
 girara_list_t* pdf_page_images_get(zathura_page_t* page, void* data, zathura_error_t* error) {
   if (page == NULL || data == NULL) {
     zathura_check_set_error(error, ZATHURA_ERROR_INVALID_ARGUMENTS);
     return NULL;
   }
 
-  girara_list_t* list  = NULL;
-  GList* image_mapping = NULL;
-
-  PopplerPage* poppler_page = data;
-  image_mapping             = poppler_page_get_image_mapping(poppler_page);
-  if (image_mapping == NULL || g_list_length(image_mapping) == 0) {
+  girara_list_t* list = NULL;
+  GArray* images      = pdf_page_get_image_mapping(data);
+  if (images == NULL || images->len == 0) {
     zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
     goto error_free;
   }
@@ -33,35 +97,33 @@ girara_list_t* pdf_page_images_get(zathura_page_t* page, void* data, zathura_err
     goto error_free;
   }
 
-  for (GList* image = image_mapping; image != NULL; image = g_list_next(image)) {
+  for (guint n = 0; n < images->len; ++n) {
+    const pdf_image_t* pdf_image = &g_array_index(images, pdf_image_t, n);
+
     zathura_image_t* zathura_image = g_try_malloc0(sizeof(zathura_image_t));
     if (zathura_image == NULL) {
       zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
       goto error_free;
     }
 
-    PopplerImageMapping* poppler_image = (PopplerImageMapping*)image->data;
-
     /* extract id */
     zathura_image->data = g_try_malloc(sizeof(gint));
     if (zathura_image->data == NULL) {
+      g_free(zathura_image);
       zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
       goto error_free;
     }
 
     gint* image_id = zathura_image->data;
-    *image_id      = poppler_image->image_id;
+    *image_id      = pdf_image->id;
 
     /* extract position */
-    zathura_image->position.x1 = poppler_image->area.x1;
-    zathura_image->position.x2 = poppler_image->area.x2;
-    zathura_image->position.y1 = poppler_image->area.y1;
-    zathura_image->position.y2 = poppler_image->area.y2;
+    zathura_image->position = pdf_image->position;
 
     girara_list_append(list, zathura_image);
   }
 
-  poppler_page_free_image_mapping(image_mapping);
+  g_array_unref(images);
 
   return list;
 
@@ -70,8 +132,8 @@ error_free:
     girara_list_free(list);
   }
 
-  if (image_mapping != NULL) {
-    poppler_page_free_image_mapping(image_mapping);
+  if (images != NULL) {
+    g_array_unref(images);
   }
 
   return NULL;
@@ -84,14 +146,188 @@ cairo_surface_t* pdf_page_image_get_cairo(zathura_page_t* page, void* data, zath
     return NULL;
   }
 
-  gint* image_id = (gint*)image->data;
+  pdf_page_t* pdf_page = data;
+  gint* image_id       = (gint*)image->data;
+  pdf_cache_t* cache   = pdf_page->document->image_cache;
+
+  image_key_t key;
+  memset(&key, 0, sizeof(key));
+  key.page = pdf_page->index;
+  key.id   = *image_id;
+
+  /* the cached surfaces are shared, callers must not draw onto them */
+  cairo_surface_t* surface = cache != NULL ? pdf_cache_lookup(cache, &key, sizeof(key)) : NULL;
+  if (surface != NULL) {
+    return surface;
+  }
 
-  PopplerPage* poppler_page = data;
-  cairo_surface_t* surface  = poppler_page_get_image(poppler_page, *image_id);
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+  if (poppler_page == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
+    return NULL;
+  }
+
+  surface = poppler_page_get_image(poppler_page, *image_id);
+  g_object_unref(poppler_page);
   if (surface == NULL) {
     zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
     return NULL;
   }
 
+  if (cache != NULL && cairo_surface_get_type(surface) == CAIRO_SURFACE_TYPE_IMAGE) {
+    pdf_cache_insert(cache, &key, sizeof(key), surface);
+  }
+
+  return surface;
+}
+
+/*
+ * Area-averaging downsampler, the target must not be larger than the source. Source columns are mapped to
+ * destination columns once, then every source row is accumulated into per-column sums, which keeps the inner loop
+ * free of divisions. Transparent pixels are composited over white when converting to A8.
+ */
+static void downsample_box(cairo_surface_t* source, cairo_surface_t* target) {
+  cairo_surface_flush(source);
+  cairo_surface_flush(target);
+
+  const int source_width       = cairo_image_surface_get_width(source);
+  const int source_height      = cairo_image_surface_get_height(source);
+  const int source_stride      = cairo_image_surface_get_stride(source);
+  const unsigned char* sources = cairo_image_surface_get_data(source);
+  const bool opaque            = cairo_image_surface_get_format(source) == CAIRO_FORMAT_RGB24;
+
+  const int width        = cairo_image_surface_get_width(target);
+  const int height       = cairo_image_surface_get_height(target);
+  const int stride       = cairo_image_surface_get_stride(target);
+  unsigned char* targets = cairo_image_surface_get_data(target);
+  const bool gray        = cairo_image_surface_get_format(target) == CAIRO_FORMAT_A8;
+
+  int* columns    = g_malloc_n(source_width, sizeof(int));
+  guint32* counts = g_malloc0_n(width, sizeof(guint32));
+  guint32* sums   = g_malloc_n((gsize)width * 4, sizeof(guint32));
+
+  for (int x = 0; x < source_width; ++x) {
+    columns[x] = MIN((int)((gint64)x * width / source_width), width - 1);
+    counts[columns[x]]++;
+  }
+
+  int source_y = 0;
+  for (int y = 0; y < height; ++y) {
+    const int source_end = MAX(source_y + 1, (int)((gint64)(y + 1) * source_height / height));
+    const guint32 rows   = MIN(source_end, source_height) - source_y;
+    memset(sums, 0, (gsize)width * 4 * sizeof(guint32));
+
+    for (; source_y < source_end && source_y < source_height; ++source_y) {
+      const guint32* row = (const guint32*)(sources + (gsize)source_y * source_stride);
+      for (int x = 0; x < source_width; ++x) {
+        const guint32 pixel = opaque == true ? row[x] | 0xff000000 : row[x];
+        guint32* sum        = sums + columns[x] * 4;
+        sum[0] += (pixel >> 24) & 0xff;
+        sum[1] += (pixel >> 16) & 0xff;
+        sum[2] += (pixel >> 8) & 0xff;
+        sum[3] += pixel & 0xff;
+      }
+    }
+
+    unsigned char* out = targets + (gsize)y * stride;
+    for (int x = 0; x < width; ++x) {
+      const guint32 area = MAX(1, counts[x] * rows);
+      const guint32 a    = sums[x * 4 + 0] / area;
+      const guint32 r    = sums[x * 4 + 1] / area;
+      const guint32 g    = sums[x * 4 + 2] / area;
+      const guint32 b    = sums[x * 4 + 3] / area;
+
+      if (gray == true) {
+        /* the channels are premultiplied, so adding the missing alpha composites over white */
+        out[x] = MIN(255, ((77 * r + 150 * g + 29 * b) >> 8) + (255 - a));
+      } else {
+        ((guint32*)out)[x] = (a << 24) | (r << 16) | (g << 8) | b;
+      }
+    }
+  }
+
+  g_free(sums);
+  g_free(counts);
+  g_free(columns);
+
+  cairo_surface_mark_dirty(target);
+}
+
+cairo_surface_t* pdf_page_image_get_cairo_scaled(zathura_page_t* page, void* data, zathura_image_t* image,
+                                                 unsigned int width, unsigned int height, cairo_format_t format,
+                                                 zathura_error_t* error) {
+  if (page == NULL || data == NULL || image == NULL || image->data == NULL || (width == 0 && height == 0) ||
+      (format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_A8)) {
+    zathura_check_set_error(error, ZATHURA_ERROR_INVALID_ARGUMENTS);
+    return NULL;
+  }
+
+  /* keep the aspect ratio of the image on the page if only one dimension is given */
+  const double image_width  = fabs(image->position.x2 - image->position.x1);
+  const double image_height = fabs(image->position.y2 - image->position.y1);
+  if (image_width <= 0 || image_height <= 0) {
+    zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
+    return NULL;
+  }
+  if (width == 0) {
+    width = MAX(1, (unsigned int)round(height * image_width / image_height));
+  } else if (height == 0) {
+    height = MAX(1, (unsigned int)round(width * image_height / image_width));
+  }
+
+  /* the decoded image is the only source, so the result is the same whether it was cached or not */
+  cairo_surface_t* decoded = pdf_page_image_get_cairo(page, data, image, error);
+  if (decoded == NULL) {
+    return NULL;
+  }
+  if (cairo_surface_get_type(decoded) != CAIRO_SURFACE_TYPE_IMAGE) {
+    cairo_surface_destroy(decoded);
+    zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
+    return NULL;
+  }
+
+  cairo_surface_t* surface = cairo_image_surface_create(format, width, height);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    cairo_surface_destroy(decoded);
+    zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+    return NULL;
+  }
+
+  const int decoded_width  = cairo_image_surface_get_width(decoded);
+  const int decoded_height = cairo_image_surface_get_height(decoded);
+  if (decoded_width >= (int)width && decoded_height >= (int)height) {
+    downsample_box(decoded, surface);
+    cairo_surface_destroy(decoded);
+    return surface;
+  }
+
+  /* the box filter only reduces, enlarged images are interpolated by cairo and converted to A8 afterwards */
+  cairo_surface_t* target = surface;
+  if (format == CAIRO_FORMAT_A8) {
+    target = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    if (cairo_surface_status(target) != CAIRO_STATUS_SUCCESS) {
+      cairo_surface_destroy(target);
+      cairo_surface_destroy(surface);
+      cairo_surface_destroy(decoded);
+      zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+      return NULL;
+    }
+  }
+
+  cairo_t* cairo = cairo_create(target);
+  cairo_scale(cairo, (double)width / decoded_width, (double)height / decoded_height);
+  cairo_set_source_surface(cairo, decoded, 0, 0);
+  cairo_pattern_set_filter(cairo_get_source(cairo), CAIRO_FILTER_GOOD);
+  cairo_pattern_set_extend(cairo_get_source(cairo), CAIRO_EXTEND_PAD);
+  cairo_paint(cairo);
+  cairo_destroy(cairo);
+  cairo_surface_destroy(decoded);
+
+  if (target != surface) {
+    downsample_box(target, surface);
+    cairo_surface_destroy(target);
+  }
+
   return surface;
 }
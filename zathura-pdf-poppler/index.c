@@ -1,40 +1,183 @@
 /* SPDX-License-Identifier: Zlib */
 
 #include "plugin.h"
+#include "index.h"
 #include "utils.h"
 
-static void build_index(PopplerDocument* poppler_document, girara_tree_node_t* root, PopplerIndexIter* iter);
+struct pdf_outline_node_s {
+  char* title;            /* Title of the entry */
+  PopplerAction* action;  /* Action of the entry */
+  zathura_link_t* link;   /* Resolved link */
+  bool resolved;          /* Whether the link has been resolved */
+  PopplerIndexIter* iter; /* Iterator over the children until they have been read */
+  GPtrArray* children;    /* Children (NULL until read) */
+};
+
+static void outline_node_free(void* data) {
+  pdf_outline_node_t* node = data;
+  if (node == NULL) {
+    return;
+  }
 
-girara_tree_node_t* pdf_document_index_generate(zathura_document_t* document, void* data, zathura_error_t* error) {
+  if (node->children != NULL) {
+    g_ptr_array_unref(node->children);
+  }
+  if (node->iter != NULL) {
+    poppler_index_iter_free(node->iter);
+  }
+  if (node->link != NULL) {
+    zathura_link_free(node->link);
+  }
+  if (node->action != NULL) {
+    poppler_action_free(node->action);
+  }
+  g_free(node->title);
+  g_free(node);
+}
+
+void pdf_document_outline_init(pdf_document_t* pdf_document) {
+  pdf_document->outline.root = NULL;
+  g_mutex_init(&pdf_document->outline.lock);
+}
+
+void pdf_document_outline_clear(pdf_document_t* pdf_document) {
+  outline_node_free(pdf_document->outline.root);
+  pdf_document->outline.root = NULL;
+  g_mutex_clear(&pdf_document->outline.lock);
+}
+
+/* Reads the direct children of a node. Needs to be called with the outline lock held. */
+static void outline_node_expand(pdf_outline_node_t* node) {
+  if (node->children != NULL) {
+    return;
+  }
+
+  node->children = g_ptr_array_new_with_free_func(outline_node_free);
+  if (node->iter == NULL) {
+    return;
+  }
+
+  PopplerIndexIter* iter = node->iter;
+  node->iter             = NULL;
+
+  do {
+    PopplerAction* action = poppler_index_iter_get_action(iter);
+    if (action == NULL) {
+      continue;
+    }
+
+    pdf_outline_node_t* child = g_try_malloc0(sizeof(pdf_outline_node_t));
+    if (child == NULL) {
+      poppler_action_free(action);
+      continue;
+    }
+
+    child->title  = g_strdup(action->any.title);
+    child->action = action;
+    child->iter   = poppler_index_iter_get_child(iter);
+    g_ptr_array_add(node->children, child);
+  } while (poppler_index_iter_next(iter));
+
+  poppler_index_iter_free(iter);
+}
+
+/* Resolves the link of a node. Needs to be called with the outline lock held. */
+static zathura_link_t* outline_node_resolve(pdf_document_t* pdf_document, pdf_outline_node_t* node) {
+  if (node->resolved == false && node->action != NULL) {
+    zathura_rectangle_t rect = {0, 0, 0, 0};
+    node->link               = poppler_link_to_zathura_link(pdf_document, node->action, rect);
+    node->resolved           = true;
+  }
+
+  return node->link;
+}
+
+pdf_outline_node_t* pdf_document_outline_get_root(zathura_document_t* document, void* data, zathura_error_t* error) {
   if (document == NULL || data == NULL) {
     zathura_check_set_error(error, ZATHURA_ERROR_INVALID_ARGUMENTS);
     return NULL;
   }
 
-  PopplerDocument* poppler_document = data;
-  PopplerIndexIter* iter            = poppler_index_iter_new(poppler_document);
+  pdf_document_t* pdf_document = data;
+
+  g_mutex_lock(&pdf_document->outline.lock);
+  if (pdf_document->outline.root == NULL) {
+    PopplerIndexIter* iter = poppler_index_iter_new(pdf_document->document);
+    if (iter != NULL) {
+      pdf_outline_node_t* root = g_try_malloc0(sizeof(pdf_outline_node_t));
+      if (root != NULL) {
+        root->title = g_strdup("ROOT");
+        root->iter  = iter;
+        outline_node_expand(root);
+      } else {
+        poppler_index_iter_free(iter);
+      }
+      pdf_document->outline.root = root;
+    }
+  }
+  pdf_outline_node_t* root = pdf_document->outline.root;
+  g_mutex_unlock(&pdf_document->outline.lock);
 
-  if (iter == NULL) {
+  if (root == NULL) {
     zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+  }
+
+  return root;
+}
+
+unsigned int pdf_outline_node_get_n_children(void* data, pdf_outline_node_t* node) {
+  if (data == NULL || node == NULL) {
+    return 0;
+  }
+
+  pdf_document_t* pdf_document = data;
+
+  g_mutex_lock(&pdf_document->outline.lock);
+  outline_node_expand(node);
+  const unsigned int n_children = node->children->len;
+  g_mutex_unlock(&pdf_document->outline.lock);
+
+  return n_children;
+}
+
+pdf_outline_node_t* pdf_outline_node_get_child(void* data, pdf_outline_node_t* node, unsigned int n) {
+  if (data == NULL || node == NULL) {
     return NULL;
   }
 
-  girara_tree_node_t* root = girara_node_new(zathura_index_element_new("ROOT"));
-  // girara_node_set_free_function(root, (girara_free_function_t) zathura_index_element_free);
-  build_index(poppler_document, root, iter);
+  pdf_document_t* pdf_document = data;
 
-  poppler_index_iter_free(iter);
-  return root;
+  g_mutex_lock(&pdf_document->outline.lock);
+  outline_node_expand(node);
+  pdf_outline_node_t* child = n < node->children->len ? g_ptr_array_index(node->children, n) : NULL;
+  g_mutex_unlock(&pdf_document->outline.lock);
+
+  return child;
 }
 
-static void build_index(PopplerDocument* poppler_document, girara_tree_node_t* root, PopplerIndexIter* iter) {
-  if (poppler_document == NULL || root == NULL || iter == NULL) {
-    return;
+const char* pdf_outline_node_get_title(pdf_outline_node_t* node) {
+  return node != NULL ? node->title : NULL;
+}
+
+zathura_link_t* pdf_outline_node_get_link(void* data, pdf_outline_node_t* node) {
+  if (data == NULL || node == NULL) {
+    return NULL;
   }
 
+  pdf_document_t* pdf_document = data;
+
+  g_mutex_lock(&pdf_document->outline.lock);
+  zathura_link_t* link = outline_node_resolve(pdf_document, node);
+  g_mutex_unlock(&pdf_document->outline.lock);
+
+  return link;
+}
+
+/* zathura asks for the whole index at once and owns its links, so the index is built straight from poppler's
+ * iterator. The outline nodes are only for hosts that browse the outline. */
+static void build_index(pdf_document_t* pdf_document, girara_tree_node_t* root, PopplerIndexIter* iter) {
   do {
     PopplerAction* action = poppler_index_iter_get_action(iter);
-
     if (action == NULL) {
       continue;
     }
@@ -46,23 +189,39 @@ static void build_index(PopplerDocument* poppler_document, girara_tree_node_t* r
     }
 
     zathura_rectangle_t rect = {0, 0, 0, 0};
-    index_element->link      = poppler_link_to_zathura_link(poppler_document, action, rect);
+    index_element->link      = poppler_link_to_zathura_link(pdf_document, action, rect);
+    poppler_action_free(action);
     if (index_element->link == NULL) {
       zathura_index_element_free(index_element);
-      poppler_action_free(action);
       continue;
     }
 
-    poppler_action_free(action);
-
     girara_tree_node_t* node = girara_node_append_data(root, index_element);
     PopplerIndexIter* child  = poppler_index_iter_get_child(iter);
-
     if (child != NULL) {
-      build_index(poppler_document, node, child);
+      build_index(pdf_document, node, child);
+      poppler_index_iter_free(child);
     }
+  } while (poppler_index_iter_next(iter));
+}
+
+girara_tree_node_t* pdf_document_index_generate(zathura_document_t* document, void* data, zathura_error_t* error) {
+  if (document == NULL || data == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_INVALID_ARGUMENTS);
+    return NULL;
+  }
 
-    poppler_index_iter_free(child);
+  pdf_document_t* pdf_document = data;
+  PopplerIndexIter* iter       = poppler_index_iter_new(pdf_document->document);
+  if (iter == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+    return NULL;
+  }
 
-  } while (poppler_index_iter_next(iter));
+  girara_tree_node_t* root = girara_node_new(zathura_index_element_new("ROOT"));
+  // girara_node_set_free_function(root, (girara_free_function_t) zathura_index_element_free);
+  build_index(pdf_document, root, iter);
+
+  poppler_index_iter_free(iter);
+  return root;
 }
@@ -0,0 +1,22 @@
+/* SPDX-License-Identifier: Zlib */
+
+#ifndef INDEX_H
+#define INDEX_H
+
+#include "plugin.h"
+
+/**
+ * Initializes the outline of a document
+ *
+ * @param pdf_document The document
+ */
+void pdf_document_outline_init(pdf_document_t* pdf_document);
+
+/**
+ * Frees the outline of a document
+ *
+ * @param pdf_document The document
+ */
+void pdf_document_outline_clear(pdf_document_t* pdf_document);
+
+#endif // INDEX_H
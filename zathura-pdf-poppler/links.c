@@ -1,68 +1,304 @@
 /* SPDX-License-Identifier: Zlib */
 
+#include <math.h>
+#include <string.h>
+
 #include "plugin.h"
+#include "links.h"
+#include "page.h"
 #include "utils.h"
 
-girara_list_t* pdf_page_links_get(zathura_page_t* page, void* data, zathura_error_t* error) {
-  if (page == NULL || data == NULL) {
-    zathura_check_set_error(error, ZATHURA_ERROR_INVALID_ARGUMENTS);
-    goto error_ret;
+/* Maximal number of grid columns and rows */
+#define PDF_LINKS_GRID_MAX 64
+
+static guint grid_cell(double value, double cell_size, guint cells) {
+  if (value <= 0 || cell_size <= 0) {
+    return 0;
   }
 
-  girara_list_t* list       = NULL;
-  GList* link_mapping       = NULL;
-  PopplerPage* poppler_page = data;
+  const double cell = floor(value / cell_size);
+  return cell >= cells ? cells - 1 : (guint)cell;
+}
 
-  link_mapping = poppler_page_get_link_mapping(poppler_page);
-  if (link_mapping == NULL || g_list_length(link_mapping) == 0) {
-    zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
+pdf_links_t* pdf_links_new(PopplerPage* poppler_page, double width, double height) {
+  pdf_links_t* links = g_try_malloc0(sizeof(pdf_links_t));
+  if (links == NULL) {
+    return NULL;
+  }
+
+  GList* link_mapping = poppler_page_get_link_mapping(poppler_page);
+  link_mapping        = g_list_reverse(link_mapping);
+
+  links->length = g_list_length(link_mapping);
+  if (links->length != 0) {
+    links->links = g_try_malloc0_n(links->length, sizeof(*links->links));
+    if (links->links == NULL) {
+      goto error_free;
+    }
+  }
+
+  guint n = 0;
+  for (GList* link = link_mapping; link != NULL; link = g_list_next(link), ++n) {
+    PopplerLinkMapping* poppler_link = (PopplerLinkMapping*)link->data;
+
+    links->links[n].position.x1 = poppler_link->area.x1;
+    links->links[n].position.x2 = poppler_link->area.x2;
+    links->links[n].position.y1 = height - poppler_link->area.y2;
+    links->links[n].position.y2 = height - poppler_link->area.y1;
+    links->links[n].action      = poppler_action_copy(poppler_link->action);
+  }
+
+  /* aim for a couple of links per cell */
+  const guint cells   = CLAMP((guint)ceil(sqrt(links->length / 2.0)), 1, PDF_LINKS_GRID_MAX);
+  links->columns      = cells;
+  links->rows         = cells;
+  links->cell_width   = width / cells;
+  links->cell_height  = height / cells;
+  links->cell_offsets = g_try_malloc0_n(cells * cells + 1, sizeof(guint));
+  if (links->cell_offsets == NULL) {
     goto error_free;
   }
-  link_mapping = g_list_reverse(link_mapping);
 
-  list = girara_list_new_with_free((girara_free_function_t)zathura_link_free);
-  if (list == NULL) {
-    zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+  /* count the links of every cell, ... */
+  for (n = 0; n < links->length; ++n) {
+    const zathura_rectangle_t* position = &links->links[n].position;
+    const guint x1                      = grid_cell(position->x1, links->cell_width, links->columns);
+    const guint x2                      = grid_cell(position->x2, links->cell_width, links->columns);
+    const guint y1                      = grid_cell(position->y1, links->cell_height, links->rows);
+    const guint y2                      = grid_cell(position->y2, links->cell_height, links->rows);
+    for (guint y = y1; y <= y2; ++y) {
+      for (guint x = x1; x <= x2; ++x) {
+        links->cell_offsets[y * links->columns + x + 1]++;
+      }
+    }
+  }
+
+  /* ... turn the counts into offsets ... */
+  for (guint cell = 1; cell <= cells * cells; ++cell) {
+    links->cell_offsets[cell] += links->cell_offsets[cell - 1];
+  }
+
+  const guint total = links->cell_offsets[cells * cells];
+  if (total != 0) {
+    links->cell_links = g_try_malloc_n(total, sizeof(guint));
+    if (links->cell_links == NULL) {
+      goto error_free;
+    }
+  }
+
+  /* ... and fill the cells in link order */
+  guint* fill = g_try_malloc_n(cells * cells, sizeof(guint));
+  if (fill == NULL) {
     goto error_free;
   }
+  memcpy(fill, links->cell_offsets, cells * cells * sizeof(guint));
+
+  for (n = 0; n < links->length; ++n) {
+    const zathura_rectangle_t* position = &links->links[n].position;
+    const guint x1                      = grid_cell(position->x1, links->cell_width, links->columns);
+    const guint x2                      = grid_cell(position->x2, links->cell_width, links->columns);
+    const guint y1                      = grid_cell(position->y1, links->cell_height, links->rows);
+    const guint y2                      = grid_cell(position->y2, links->cell_height, links->rows);
+    for (guint y = y1; y <= y2; ++y) {
+      for (guint x = x1; x <= x2; ++x) {
+        links->cell_links[fill[y * links->columns + x]++] = n;
+      }
+    }
+  }
+  g_free(fill);
 
-  zathura_document_t* zathura_document = (zathura_document_t*)zathura_page_get_document(page);
-  PopplerDocument* poppler_document    = zathura_document_get_data(zathura_document);
+  poppler_page_free_link_mapping(link_mapping);
 
-  const double page_height = zathura_page_get_height(page);
+  return links;
 
-  for (GList* link = link_mapping; link != NULL; link = g_list_next(link)) {
-    PopplerLinkMapping* poppler_link = (PopplerLinkMapping*)link->data;
+error_free:
+
+  poppler_page_free_link_mapping(link_mapping);
+  pdf_links_free(links);
+
+  return NULL;
+}
+
+void pdf_links_free(pdf_links_t* links) {
+  if (links == NULL) {
+    return;
+  }
+
+  if (links->links != NULL) {
+    for (guint n = 0; n < links->length; ++n) {
+      if (links->links[n].action != NULL) {
+        poppler_action_free(links->links[n].action);
+      }
+    }
+    g_free(links->links);
+  }
+  g_free(links->cell_offsets);
+  g_free(links->cell_links);
+  g_free(links);
+}
+
+static pdf_links_t* pdf_page_store_link_index(pdf_page_t* pdf_page, pdf_links_t* links) {
+  /* another thread might have been faster */
+  g_mutex_lock(&pdf_page->lock);
+  if (pdf_page->links == NULL) {
+    pdf_page->links = links;
+  } else {
+    pdf_links_free(links);
+  }
+  links = pdf_page->links;
+  g_mutex_unlock(&pdf_page->lock);
+
+  return links;
+}
+
+static pdf_links_t* pdf_page_build_link_index(pdf_page_t* pdf_page, PopplerPage* poppler_page) {
+  pdf_document_t* pdf_document = pdf_page->document;
 
-    /* extract position */
-    const zathura_rectangle_t position = {
-        .x1 = poppler_link->area.x1,
-        .x2 = poppler_link->area.x2,
-        .y1 = page_height - poppler_link->area.y2,
-        .y2 = page_height - poppler_link->area.y1,
-    };
+  pdf_links_t* links = pdf_links_new(poppler_page, pdf_document->geometry[pdf_page->index].width,
+                                     pdf_document->geometry[pdf_page->index].height);
+  g_object_unref(poppler_page);
+
+  return links != NULL ? pdf_page_store_link_index(pdf_page, links) : NULL;
+}
+
+pdf_links_t* pdf_page_get_link_index(pdf_page_t* pdf_page) {
+  if (pdf_page == NULL) {
+    return NULL;
+  }
+
+  g_mutex_lock(&pdf_page->lock);
+  pdf_links_t* links = pdf_page->links;
+  g_mutex_unlock(&pdf_page->lock);
+
+  if (links != NULL) {
+    return links;
+  }
 
-    zathura_link_t* zathura_link = poppler_link_to_zathura_link(poppler_document, poppler_link->action, position);
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+  if (poppler_page == NULL) {
+    return NULL;
+  }
+
+  return pdf_page_build_link_index(pdf_page, poppler_page);
+}
+
+pdf_links_t* pdf_page_get_link_index_from(pdf_page_t* pdf_page, PopplerDocument* poppler_document) {
+  if (pdf_page == NULL || poppler_document == NULL) {
+    return NULL;
+  }
+
+  g_mutex_lock(&pdf_page->lock);
+  pdf_links_t* links = pdf_page->links;
+  g_mutex_unlock(&pdf_page->lock);
+
+  if (links != NULL) {
+    return links;
+  }
+
+  PopplerPage* poppler_page = poppler_document_get_page(poppler_document, pdf_page->index);
+  if (poppler_page == NULL) {
+    return NULL;
+  }
+
+  return pdf_page_build_link_index(pdf_page, poppler_page);
+}
+
+static gint compare_link_index(gconstpointer a, gconstpointer b) {
+  const guint lhs = *(const guint*)a;
+  const guint rhs = *(const guint*)b;
+
+  return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+}
+
+girara_list_t* pdf_page_links_get(zathura_page_t* page, void* data, zathura_error_t* error) {
+  if (page == NULL || data == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_INVALID_ARGUMENTS);
+    return NULL;
+  }
+
+  pdf_page_t* pdf_page = data;
+  pdf_links_t* links   = pdf_page_get_link_index(pdf_page);
+  if (links == NULL || links->length == 0) {
+    zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
+    return NULL;
+  }
+
+  girara_list_t* list = girara_list_new_with_free((girara_free_function_t)zathura_link_free);
+  if (list == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+    return NULL;
+  }
+
+  for (guint n = 0; n < links->length; ++n) {
+    zathura_link_t* zathura_link =
+        poppler_link_to_zathura_link(pdf_page->document, links->links[n].action, links->links[n].position);
     if (zathura_link != NULL) {
       girara_list_append(list, zathura_link);
     }
   }
 
-  poppler_page_free_link_mapping(link_mapping);
-
   return list;
+}
 
-error_free:
+girara_list_t* pdf_page_links_get_at(zathura_page_t* page, void* data, zathura_rectangle_t area,
+                                     zathura_error_t* error) {
+  if (page == NULL || data == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_INVALID_ARGUMENTS);
+    return NULL;
+  }
 
-  if (list != NULL) {
-    girara_list_free(list);
+  pdf_page_t* pdf_page = data;
+  pdf_links_t* links   = pdf_page_get_link_index(pdf_page);
+  if (links == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
+    return NULL;
   }
 
-  if (link_mapping != NULL) {
-    poppler_page_free_link_mapping(link_mapping);
+  girara_list_t* list = girara_list_new_with_free((girara_free_function_t)zathura_link_free);
+  if (list == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+    return NULL;
   }
 
-error_ret:
+  if (links->length == 0) {
+    return list;
+  }
 
-  return NULL;
+  /* collect the candidates of all cells overlapping the area */
+  const guint x1 = grid_cell(area.x1, links->cell_width, links->columns);
+  const guint x2 = grid_cell(area.x2, links->cell_width, links->columns);
+  const guint y1 = grid_cell(area.y1, links->cell_height, links->rows);
+  const guint y2 = grid_cell(area.y2, links->cell_height, links->rows);
+
+  GArray* candidates = g_array_new(FALSE, FALSE, sizeof(guint));
+  for (guint y = y1; y <= y2; ++y) {
+    for (guint x = x1; x <= x2; ++x) {
+      const guint cell = y * links->columns + x;
+      g_array_append_vals(candidates, links->cell_links + links->cell_offsets[cell],
+                          links->cell_offsets[cell + 1] - links->cell_offsets[cell]);
+    }
+  }
+
+  /* links spanning several cells are found more than once; keep the document order */
+  g_array_sort(candidates, compare_link_index);
+
+  for (guint i = 0; i < candidates->len; ++i) {
+    const guint n = g_array_index(candidates, guint, i);
+    if (i > 0 && g_array_index(candidates, guint, i - 1) == n) {
+      continue;
+    }
+
+    const zathura_rectangle_t* position = &links->links[n].position;
+    if (position->x2 < area.x1 || position->x1 > area.x2 || position->y2 < area.y1 || position->y1 > area.y2) {
+      continue;
+    }
+
+    zathura_link_t* zathura_link = poppler_link_to_zathura_link(pdf_page->document, links->links[n].action, *position);
+    if (zathura_link != NULL) {
+      girara_list_append(list, zathura_link);
+    }
+  }
+  g_array_free(candidates, TRUE);
+
+  return list;
 }
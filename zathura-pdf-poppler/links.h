@@ -0,0 +1,62 @@
+/* SPDX-License-Identifier: Zlib */
+
+#ifndef LINKS_H
+#define LINKS_H
+
+#include "plugin.h"
+
+/**
+ * Cached links of a page together with a uniform grid over their rectangles
+ */
+typedef struct pdf_links_s {
+  struct {
+    zathura_rectangle_t position; /**< Position of the link (top-left origin) */
+    PopplerAction* action;        /**< Action of the link */
+  }* links;                       /**< Links in document order */
+  guint length;                   /**< Number of links */
+
+  guint columns;       /**< Number of grid columns */
+  guint rows;          /**< Number of grid rows */
+  double cell_width;   /**< Width of a grid cell */
+  double cell_height;  /**< Height of a grid cell */
+  guint* cell_offsets; /**< Offset of every cell into cell_links (columns * rows + 1 entries) */
+  guint* cell_links;   /**< Link indices of all cells */
+} pdf_links_t;
+
+/**
+ * Reads the links of a page and builds the grid
+ *
+ * @param poppler_page The poppler page
+ * @param width Width of the page
+ * @param height Height of the page
+ * @return Links or NULL if an error occurred
+ */
+pdf_links_t* pdf_links_new(PopplerPage* poppler_page, double width, double height);
+
+/**
+ * Frees the links of a page
+ *
+ * @param links The links
+ */
+void pdf_links_free(pdf_links_t* links);
+
+/**
+ * Returns the cached links of a page and reads them on first use
+ *
+ * @param pdf_page The page
+ * @return Links or NULL if an error occurred
+ */
+pdf_links_t* pdf_page_get_link_index(pdf_page_t* pdf_page);
+
+/**
+ * Returns the cached links of a page and reads them from the given poppler
+ * document on first use. Used by worker threads that own a secondary poppler
+ * document.
+ *
+ * @param pdf_page The page
+ * @param poppler_document The poppler document to read the links from
+ * @return Links or NULL if an error occurred
+ */
+pdf_links_t* pdf_page_get_link_index_from(pdf_page_t* pdf_page, PopplerDocument* poppler_document);
+
+#endif // LINKS_H
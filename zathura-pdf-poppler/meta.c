@@ -3,6 +3,7 @@
 #include <string.h>
 
 #include "plugin.h"
+#include "page.h"
 
 #define LENGTH(x) (sizeof(x) / sizeof((x)[0]))
 
@@ -12,7 +13,8 @@ girara_list_t* pdf_document_get_information(zathura_document_t* document, void*
     return NULL;
   }
 
-  PopplerDocument* poppler_document = data;
+  pdf_document_t* pdf_document      = data;
+  PopplerDocument* poppler_document = pdf_document->document;
   girara_list_t* list               = zathura_document_information_entry_list_new();
   if (list == NULL) {
     zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
@@ -74,8 +76,13 @@ zathura_error_t pdf_page_get_label(zathura_page_t* page, void* data, char** labe
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
-  PopplerPage* poppler_page = data;
-  *label                    = poppler_page_get_label(poppler_page);
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(data);
+  if (poppler_page == NULL) {
+    return ZATHURA_ERROR_UNKNOWN;
+  }
+
+  *label = poppler_page_get_label(poppler_page);
+  g_object_unref(poppler_page);
 
   return ZATHURA_ERROR_OK;
 }
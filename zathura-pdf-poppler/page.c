@@ -1,33 +1,117 @@
 /* SPDX-License-Identifier: Zlib */
 
 #include "plugin.h"
+#include "links.h"
+#include "page.h"
+#include "prefetch.h"
+#include "text.h"
+#include "utils.h"
+
+void pdf_document_lru_init(pdf_document_t* pdf_document) {
+  g_queue_init(&pdf_document->lru.pages);
+  pdf_document->lru.capacity = MAX(1, pdf_getenv_uint(PDF_PAGE_CACHE_ENV, PDF_PAGE_CACHE_DEFAULT));
+  g_mutex_init(&pdf_document->lru.lock);
+}
+
+void pdf_document_lru_clear(pdf_document_t* pdf_document) {
+  /* the pages remove themselves in pdf_page_clear */
+  g_mutex_clear(&pdf_document->lru.lock);
+}
+
+static void pdf_page_release_poppler_page(pdf_page_t* pdf_page) {
+  g_mutex_lock(&pdf_page->lock);
+  PopplerPage* poppler_page = pdf_page->page;
+  pdf_page->page            = NULL;
+  g_mutex_unlock(&pdf_page->lock);
+
+  if (poppler_page != NULL) {
+    g_object_unref(poppler_page);
+  }
+}
+
+static void pdf_page_lru_touch(pdf_page_t* pdf_page) {
+  pdf_document_t* pdf_document = pdf_page->document;
+  GQueue evicted               = G_QUEUE_INIT;
+
+  g_mutex_lock(&pdf_document->lru.lock);
+  if (pdf_page->lru_link.data != NULL) {
+    g_queue_unlink(&pdf_document->lru.pages, &pdf_page->lru_link);
+  }
+  pdf_page->lru_link.data = pdf_page;
+  g_queue_push_head_link(&pdf_document->lru.pages, &pdf_page->lru_link);
+
+  while (pdf_document->lru.pages.length > pdf_document->lru.capacity) {
+    GList* link = g_queue_peek_tail_link(&pdf_document->lru.pages);
+    g_queue_unlink(&pdf_document->lru.pages, link);
+    g_queue_push_tail(&evicted, link->data);
+    link->data = NULL;
+  }
+  g_mutex_unlock(&pdf_document->lru.lock);
+
+  /* users of the evicted pages keep their own references */
+  for (pdf_page_t* page = g_queue_pop_head(&evicted); page != NULL; page = g_queue_pop_head(&evicted)) {
+    pdf_page_release_poppler_page(page);
+  }
+}
+
+PopplerPage* pdf_page_get_poppler_page(pdf_page_t* pdf_page) {
+  if (pdf_page == NULL) {
+    return NULL;
+  }
+
+  g_mutex_lock(&pdf_page->lock);
+  if (pdf_page->page == NULL) {
+    pdf_page->page = poppler_document_get_page(pdf_page->document->document, pdf_page->index);
+  }
+  PopplerPage* poppler_page = pdf_page->page != NULL ? g_object_ref(pdf_page->page) : NULL;
+  g_mutex_unlock(&pdf_page->lock);
+
+  if (poppler_page != NULL) {
+    pdf_page_lru_touch(pdf_page);
+  }
+
+  return poppler_page;
+}
 
 zathura_error_t pdf_page_init(zathura_page_t* page) {
   if (page == NULL) {
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
-  zathura_document_t* document      = zathura_page_get_document(page);
-  PopplerDocument* poppler_document = zathura_document_get_data(document);
+  zathura_document_t* document = zathura_page_get_document(page);
+  pdf_document_t* pdf_document = zathura_document_get_data(document);
+  const unsigned int index     = zathura_page_get_index(page);
 
-  if (poppler_document == NULL) {
+  if (pdf_document == NULL || index >= pdf_document->number_of_pages) {
     return ZATHURA_ERROR_UNKNOWN;
   }
 
-  /* init poppler data */
-  PopplerPage* poppler_page = poppler_document_get_page(poppler_document, zathura_page_get_index(page));
+  /* only the size is needed now, the page itself is created on first use */
+  PopplerPage* poppler_page = poppler_document_get_page(pdf_document->document, index);
 
   if (poppler_page == NULL) {
-    g_free(poppler_page);
     return ZATHURA_ERROR_UNKNOWN;
   }
 
-  zathura_page_set_data(page, poppler_page);
-
-  /* calculate dimensions */
   double width;
   double height;
   poppler_page_get_size(poppler_page, &width, &height);
+  g_object_unref(poppler_page);
+
+  pdf_page_t* pdf_page = g_try_malloc0(sizeof(pdf_page_t));
+  if (pdf_page == NULL) {
+    return ZATHURA_ERROR_OUT_OF_MEMORY;
+  }
+
+  pdf_page->document = pdf_document;
+  pdf_page->index    = index;
+  g_mutex_init(&pdf_page->lock);
+
+  zathura_page_set_data(page, pdf_page);
+
+  /* calculate dimensions */
+  pdf_document->geometry[index].width  = width;
+  pdf_document->geometry[index].height = height;
   zathura_page_set_width(page, width);
   zathura_page_set_height(page, height);
 
@@ -39,9 +123,27 @@ zathura_error_t pdf_page_clear(zathura_page_t* page, void* data) {
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
-  PopplerPage* poppler_page = data;
-  if (poppler_page != NULL) {
-    g_object_unref(poppler_page);
+  pdf_page_t* pdf_page = data;
+  if (pdf_page != NULL) {
+    pdf_document_t* pdf_document = pdf_page->document;
+    pdf_prefetch_cancel(pdf_document->prefetch);
+
+    g_mutex_lock(&pdf_document->lru.lock);
+    if (pdf_page->lru_link.data != NULL) {
+      g_queue_unlink(&pdf_document->lru.pages, &pdf_page->lru_link);
+      pdf_page->lru_link.data = NULL;
+    }
+    g_mutex_unlock(&pdf_document->lru.lock);
+
+    /* like an eviction, so that a thread that is materializing the page is not raced */
+    pdf_page_release_poppler_page(pdf_page);
+    pdf_page_clear_text_layout(pdf_page);
+    pdf_links_free(pdf_page->links);
+    if (pdf_page->images != NULL) {
+      g_array_unref(pdf_page->images);
+    }
+    g_mutex_clear(&pdf_page->lock);
+    g_free(pdf_page);
   }
 
   return ZATHURA_ERROR_OK;
@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: Zlib */
+
+#ifndef PAGE_H
+#define PAGE_H
+
+#include "plugin.h"
+
+/**
+ * Environment variable with the maximal number of materialized pages
+ */
+#define PDF_PAGE_CACHE_ENV "ZATHURA_PDF_POPPLER_PAGE_CACHE"
+
+/**
+ * Default maximal number of materialized pages
+ */
+#define PDF_PAGE_CACHE_DEFAULT 64
+
+/**
+ * Initializes the LRU of materialized pages
+ *
+ * @param pdf_document The document
+ */
+void pdf_document_lru_init(pdf_document_t* pdf_document);
+
+/**
+ * Clears the LRU of materialized pages
+ *
+ * @param pdf_document The document
+ */
+void pdf_document_lru_clear(pdf_document_t* pdf_document);
+
+/**
+ * Returns the poppler page of a page. The PopplerPage is created on first use
+ * and released again when it falls out of the document's LRU, hence the
+ * caller receives its own reference and has to release it with
+ * g_object_unref.
+ *
+ * @param pdf_page The page
+ * @return Poppler page or NULL if an error occurred
+ */
+PopplerPage* pdf_page_get_poppler_page(pdf_page_t* pdf_page);
+
+#endif // PAGE_H
@@ -1,27 +1,201 @@
 /* SPDX-License-Identifier: Zlib */
 
 #include "plugin.h"
+#include "trace.h"
+
+/* The callbacks are wrapped to measure their latency if ZATHURA_PDF_POPPLER_TRACE
+ * is set. Without it, the trace of every document is NULL and the wrappers only
+ * add a branch. document_free is not wrapped since it writes the trace. */
+
+#define TRACE_BEGIN(trace) const gint64 trace_start = (trace) != NULL ? pdf_trace_now() : 0
+#define TRACE_END(trace, callback, page)                                                                               \
+  if ((trace) != NULL) {                                                                                               \
+    pdf_trace_record((trace), (callback), (page), trace_start);                                                        \
+  }
+
+static pdf_trace_t* document_trace(void* data) {
+  pdf_document_t* pdf_document = data;
+  return pdf_document != NULL ? pdf_document->trace : NULL;
+}
+
+static pdf_trace_t* page_trace(void* data) {
+  pdf_page_t* pdf_page = data;
+  return pdf_page != NULL ? pdf_page->document->trace : NULL;
+}
+
+static int page_index(void* data) {
+  pdf_page_t* pdf_page = data;
+  return pdf_page != NULL ? (int)pdf_page->index : -1;
+}
+
+static zathura_error_t trace_document_open(zathura_document_t* document) {
+  const gint64 trace_start = pdf_trace_enabled() == true ? pdf_trace_now() : 0;
+
+  const zathura_error_t error = pdf_document_open(document);
+
+  pdf_trace_t* trace = error == ZATHURA_ERROR_OK ? document_trace(zathura_document_get_data(document)) : NULL;
+  TRACE_END(trace, PDF_TRACE_DOCUMENT_OPEN, -1);
+  return error;
+}
+
+static girara_tree_node_t* trace_document_index_generate(zathura_document_t* document, void* data,
+                                                         zathura_error_t* error) {
+  pdf_trace_t* trace = document_trace(data);
+  TRACE_BEGIN(trace);
+  girara_tree_node_t* result = pdf_document_index_generate(document, data, error);
+  TRACE_END(trace, PDF_TRACE_DOCUMENT_INDEX_GENERATE, -1);
+  return result;
+}
+
+static zathura_error_t trace_document_save_as(zathura_document_t* document, void* data, const char* path) {
+  pdf_trace_t* trace = document_trace(data);
+  TRACE_BEGIN(trace);
+  const zathura_error_t result = pdf_document_save_as(document, data, path);
+  TRACE_END(trace, PDF_TRACE_DOCUMENT_SAVE_AS, -1);
+  return result;
+}
+
+static girara_list_t* trace_document_attachments_get(zathura_document_t* document, void* data,
+                                                     zathura_error_t* error) {
+  pdf_trace_t* trace = document_trace(data);
+  TRACE_BEGIN(trace);
+  girara_list_t* result = pdf_document_attachments_get(document, data, error);
+  TRACE_END(trace, PDF_TRACE_DOCUMENT_ATTACHMENTS_GET, -1);
+  return result;
+}
+
+static zathura_error_t trace_document_attachment_save(zathura_document_t* document, void* data,
+                                                      const char* attachment, const char* filename) {
+  pdf_trace_t* trace = document_trace(data);
+  TRACE_BEGIN(trace);
+  const zathura_error_t result = pdf_document_attachment_save(document, data, attachment, filename);
+  TRACE_END(trace, PDF_TRACE_DOCUMENT_ATTACHMENT_SAVE, -1);
+  return result;
+}
+
+static girara_list_t* trace_document_get_information(zathura_document_t* document, void* data,
+                                                     zathura_error_t* error) {
+  pdf_trace_t* trace = document_trace(data);
+  TRACE_BEGIN(trace);
+  girara_list_t* result = pdf_document_get_information(document, data, error);
+  TRACE_END(trace, PDF_TRACE_DOCUMENT_GET_INFORMATION, -1);
+  return result;
+}
+
+static zathura_error_t trace_page_init(zathura_page_t* page) {
+  pdf_trace_t* trace = page != NULL ? document_trace(zathura_document_get_data(zathura_page_get_document(page))) : NULL;
+  TRACE_BEGIN(trace);
+  const zathura_error_t result = pdf_page_init(page);
+  TRACE_END(trace, PDF_TRACE_PAGE_INIT, (int)zathura_page_get_index(page));
+  return result;
+}
+
+static zathura_error_t trace_page_clear(zathura_page_t* page, void* data) {
+  /* the page data is freed by the callback */
+  pdf_trace_t* trace = page_trace(data);
+  const int index    = page_index(data);
+  TRACE_BEGIN(trace);
+  const zathura_error_t result = pdf_page_clear(page, data);
+  TRACE_END(trace, PDF_TRACE_PAGE_CLEAR, index);
+  return result;
+}
+
+static girara_list_t* trace_page_search_text(zathura_page_t* page, void* data, const char* text,
+                                             zathura_error_t* error) {
+  pdf_trace_t* trace = page_trace(data);
+  TRACE_BEGIN(trace);
+  girara_list_t* result = pdf_page_search_text(page, data, text, error);
+  TRACE_END(trace, PDF_TRACE_PAGE_SEARCH_TEXT, page_index(data));
+  return result;
+}
+
+static girara_list_t* trace_page_links_get(zathura_page_t* page, void* data, zathura_error_t* error) {
+  pdf_trace_t* trace = page_trace(data);
+  TRACE_BEGIN(trace);
+  girara_list_t* result = pdf_page_links_get(page, data, error);
+  TRACE_END(trace, PDF_TRACE_PAGE_LINKS_GET, page_index(data));
+  return result;
+}
+
+static girara_list_t* trace_page_images_get(zathura_page_t* page, void* data, zathura_error_t* error) {
+  pdf_trace_t* trace = page_trace(data);
+  TRACE_BEGIN(trace);
+  girara_list_t* result = pdf_page_images_get(page, data, error);
+  TRACE_END(trace, PDF_TRACE_PAGE_IMAGES_GET, page_index(data));
+  return result;
+}
+
+static char* trace_page_get_text(zathura_page_t* page, void* data, zathura_rectangle_t rectangle,
+                                 zathura_error_t* error) {
+  pdf_trace_t* trace = page_trace(data);
+  TRACE_BEGIN(trace);
+  char* result = pdf_page_get_text(page, data, rectangle, error);
+  TRACE_END(trace, PDF_TRACE_PAGE_GET_TEXT, page_index(data));
+  return result;
+}
+
+static girara_list_t* trace_page_get_selection(zathura_page_t* page, void* data, zathura_rectangle_t rectangle,
+                                               zathura_error_t* error) {
+  pdf_trace_t* trace = page_trace(data);
+  TRACE_BEGIN(trace);
+  girara_list_t* result = pdf_page_get_selection(page, data, rectangle, error);
+  TRACE_END(trace, PDF_TRACE_PAGE_GET_SELECTION, page_index(data));
+  return result;
+}
+
+static zathura_error_t trace_page_render_cairo(zathura_page_t* page, void* data, cairo_t* cairo, bool printing) {
+  pdf_trace_t* trace = page_trace(data);
+  TRACE_BEGIN(trace);
+  const zathura_error_t result = pdf_page_render_cairo(page, data, cairo, printing);
+  TRACE_END(trace, PDF_TRACE_PAGE_RENDER_CAIRO, page_index(data));
+  return result;
+}
+
+static cairo_surface_t* trace_page_image_get_cairo(zathura_page_t* page, void* data, zathura_image_t* image,
+                                                   zathura_error_t* error) {
+  pdf_trace_t* trace = page_trace(data);
+  TRACE_BEGIN(trace);
+  cairo_surface_t* result = pdf_page_image_get_cairo(page, data, image, error);
+  TRACE_END(trace, PDF_TRACE_PAGE_IMAGE_GET_CAIRO, page_index(data));
+  return result;
+}
+
+static zathura_error_t trace_page_get_label(zathura_page_t* page, void* data, char** label) {
+  pdf_trace_t* trace = page_trace(data);
+  TRACE_BEGIN(trace);
+  const zathura_error_t result = pdf_page_get_label(page, data, label);
+  TRACE_END(trace, PDF_TRACE_PAGE_GET_LABEL, page_index(data));
+  return result;
+}
+
+static girara_list_t* trace_page_get_signatures(zathura_page_t* page, void* data, zathura_error_t* error) {
+  pdf_trace_t* trace = page_trace(data);
+  TRACE_BEGIN(trace);
+  girara_list_t* result = pdf_page_get_signatures(page, data, error);
+  TRACE_END(trace, PDF_TRACE_PAGE_GET_SIGNATURES, page_index(data));
+  return result;
+}
 
 ZATHURA_PLUGIN_REGISTER_WITH_FUNCTIONS("pdf-poppler", VERSION_MAJOR, VERSION_MINOR, VERSION_REV,
                                        ZATHURA_PLUGIN_FUNCTIONS({
-                                           .document_open            = pdf_document_open,
+                                           .document_open            = trace_document_open,
                                            .document_free            = pdf_document_free,
-                                           .document_index_generate  = pdf_document_index_generate,
-                                           .document_save_as         = pdf_document_save_as,
-                                           .document_attachments_get = pdf_document_attachments_get,
-                                           .document_attachment_save = pdf_document_attachment_save,
-                                           .document_get_information = pdf_document_get_information,
-                                           .page_init                = pdf_page_init,
-                                           .page_clear               = pdf_page_clear,
-                                           .page_search_text         = pdf_page_search_text,
-                                           .page_links_get           = pdf_page_links_get,
-                                           .page_images_get          = pdf_page_images_get,
-                                           .page_get_text            = pdf_page_get_text,
-                                           .page_get_selection       = pdf_page_get_selection,
-                                           .page_render_cairo        = pdf_page_render_cairo,
-                                           .page_image_get_cairo     = pdf_page_image_get_cairo,
-                                           .page_get_label           = pdf_page_get_label,
-                                           .page_get_signatures      = pdf_page_get_signatures,
+                                           .document_index_generate  = trace_document_index_generate,
+                                           .document_save_as         = trace_document_save_as,
+                                           .document_attachments_get = trace_document_attachments_get,
+                                           .document_attachment_save = trace_document_attachment_save,
+                                           .document_get_information = trace_document_get_information,
+                                           .page_init                = trace_page_init,
+                                           .page_clear               = trace_page_clear,
+                                           .page_search_text         = trace_page_search_text,
+                                           .page_links_get           = trace_page_links_get,
+                                           .page_images_get          = trace_page_images_get,
+                                           .page_get_text            = trace_page_get_text,
+                                           .page_get_selection       = trace_page_get_selection,
+                                           .page_render_cairo        = trace_page_render_cairo,
+                                           .page_image_get_cairo     = trace_page_image_get_cairo,
+                                           .page_get_label           = trace_page_get_label,
+                                           .page_get_signatures      = trace_page_get_signatures,
                                        }),
                                        ZATHURA_PLUGIN_MIMETYPES({
                                            "application/pdf",
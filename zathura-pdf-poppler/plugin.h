@@ -4,6 +4,7 @@
 #define PDF_H
 
 #include <stdbool.h>
+#include <gio/gio.h>
 #include <poppler.h>
 
 #include <cairo.h>
@@ -14,6 +15,84 @@
 #include <zathura/document.h>
 #include <zathura/plugin-api.h>
 
+/**
+ * Internal document representation
+ */
+typedef struct pdf_document_s {
+  PopplerDocument* document; /**< Poppler document */
+  char* path;                /**< Path of the document file */
+  char* password;            /**< Password of the document */
+  GMappedFile* mapping;      /**< Memory mapping of the file shared by all poppler documents (optional) */
+
+  struct {
+    GQueue idle;       /**< Idle secondary poppler documents */
+    unsigned int size; /**< Number of opened secondary poppler documents */
+    GMutex lock;       /**< Lock for the pool */
+    GCond cond;        /**< Signaled when a document is released */
+  } pool;              /**< Pool of secondary poppler documents for worker threads */
+
+  struct pdf_fulltext_s* fulltext;     /**< Persistent full-text search index (optional) */
+  struct pdf_cache_s* render_cache;    /**< Cache of rendered pages (optional) */
+  struct pdf_cache_s* thumbnail_cache; /**< Cache of page thumbnails (optional) */
+  struct pdf_cache_s* image_cache;     /**< Cache of decoded images (optional) */
+  struct pdf_signatures_s* signatures; /**< Signature fields and their validation results */
+  struct pdf_prefetch_s* prefetch;     /**< Background warming of upcoming pages (optional) */
+  struct pdf_trace_s* trace;           /**< Callback latency instrumentation (optional) */
+
+  struct {
+    double width;  /**< Page width */
+    double height; /**< Page height */
+  }* geometry;     /**< Size of every page, filled in by pdf_page_init */
+  unsigned int number_of_pages; /**< Number of pages */
+
+  struct {
+    struct pdf_outline_node_s* root; /**< Root of the outline (built on first use) */
+    GMutex lock;                     /**< Lock for the outline */
+  } outline;                         /**< Lazily expanded outline */
+
+  struct {
+    GHashTable* named; /**< Resolved named destinations (NULL values for unknown names) */
+    GMutex lock;       /**< Lock for the table */
+  } destinations;      /**< Cache for link resolution */
+
+  struct {
+    GPtrArray* catalogue;   /**< Attachment information (pdf_attachment_info_t, built on first use) */
+    GPtrArray* attachments; /**< PopplerAttachment of every catalogue entry */
+    GHashTable* names;      /**< Attachment names to PopplerAttachment */
+    GMutex lock;            /**< Lock for the catalogue */
+  } attachments;            /**< Attachment catalogue */
+
+  struct {
+    GQueue pages;          /**< Pages with a materialized PopplerPage, most recently used first */
+    unsigned int capacity; /**< Maximal number of materialized pages */
+    GMutex lock;           /**< Lock for the queue */
+  } lru;                   /**< LRU of materialized pages */
+
+  struct {
+    GQueue pages; /**< Pages with a cached text layout, most recently used first */
+    gsize size;   /**< Bytes of all cached text layouts */
+    gsize budget; /**< Maximal number of bytes of all cached text layouts */
+    GMutex lock;  /**< Lock for the queue and the size */
+  } text_lru;     /**< LRU of cached text layouts */
+} pdf_document_t;
+
+/**
+ * Internal page representation
+ */
+typedef struct pdf_page_s {
+  pdf_document_t* document;  /**< Document the page belongs to */
+  unsigned int index;        /**< Page index */
+  PopplerPage* page;         /**< Poppler page (created on first use, released by the LRU) */
+  GList lru_link;            /**< Link in the document's LRU of materialized pages */
+  GList text_lru_link;       /**< Link in the document's LRU of cached text layouts */
+  gsize text_lru_size;       /**< Bytes accounted for the page in the document's LRU of text layouts */
+  struct pdf_text_s* text;   /**< Cached text layout (extracted on first use, released by the LRU) */
+  struct pdf_links_s* links; /**< Cached links (read on first use) */
+  GArray* images;            /**< Cached image mapping (read on first use) */
+  gint color;                /**< Whether the page has color content (see render.c, accessed atomically) */
+  GMutex lock;               /**< Lock for the cached data */
+} pdf_page_t;
+
 /**
  * Open a pdf document
  *
@@ -72,6 +151,67 @@ zathura_error_t pdf_document_save_as(zathura_document_t* document, void* poppler
 girara_tree_node_t* pdf_document_index_generate(zathura_document_t* document, void* poppler_document,
                                                 zathura_error_t* error);
 
+/**
+ * Node of the lazily expanded outline
+ */
+typedef struct pdf_outline_node_s pdf_outline_node_t;
+
+/**
+ * Returns the root of the document's outline. Only the top-level entries are
+ * read; children are read when they are first requested and destinations
+ * are resolved when a link is first requested. All results are kept for the
+ * lifetime of the document.
+ *
+ * zathura asks for the whole index at once through
+ * pdf_document_index_generate, which does not use these nodes. This and the
+ * pdf_outline_node_* functions are only available to hosts that link the
+ * plugin statically, e.g. to show a large outline one level at a time.
+ *
+ * @param document Zathura document
+ * @param data Internal document representation
+ * @param error Set to an error value (see zathura_error_t) if an
+ *   error occurred
+ * @return Root node (owned by the document) or NULL if an error occurred
+ *   (e.g.: the document has no index)
+ */
+pdf_outline_node_t* pdf_document_outline_get_root(zathura_document_t* document, void* data, zathura_error_t* error);
+
+/**
+ * Returns the number of children of an outline node, reading them on first use
+ *
+ * @param data Internal document representation
+ * @param node Outline node
+ * @return Number of children
+ */
+unsigned int pdf_outline_node_get_n_children(void* data, pdf_outline_node_t* node);
+
+/**
+ * Returns a child of an outline node
+ *
+ * @param data Internal document representation
+ * @param node Outline node
+ * @param n Index of the child
+ * @return Child node (owned by the document) or NULL if n is out of range
+ */
+pdf_outline_node_t* pdf_outline_node_get_child(void* data, pdf_outline_node_t* node, unsigned int n);
+
+/**
+ * Returns the title of an outline node
+ *
+ * @param node Outline node
+ * @return Title (owned by the node)
+ */
+const char* pdf_outline_node_get_title(pdf_outline_node_t* node);
+
+/**
+ * Returns the link of an outline node, resolving it on first use
+ *
+ * @param data Internal document representation
+ * @param node Outline node
+ * @return Link (owned by the node) or NULL if it cannot be resolved
+ */
+zathura_link_t* pdf_outline_node_get_link(void* data, pdf_outline_node_t* node);
+
 /**
  * Returns a list of attachments included in the zathura document
  *
@@ -83,6 +223,35 @@ girara_tree_node_t* pdf_document_index_generate(zathura_document_t* document, vo
 girara_list_t* pdf_document_attachments_get(zathura_document_t* document, void* poppler_document,
                                             zathura_error_t* error);
 
+/**
+ * Information about an embedded file
+ */
+typedef struct pdf_attachment_info_s {
+  char* name;      /**< File name */
+  gsize size;      /**< Size in bytes */
+  char* checksum;  /**< MD5 checksum as hexadecimal string (NULL if unknown) */
+  char* mime_type; /**< MIME type guessed from the file name */
+} pdf_attachment_info_t;
+
+/**
+ * Returns the attachment catalogue of the document. The catalogue is built
+ * once per document; the data of the attachments is not read.
+ *
+ * zathura reaches the catalogue through pdf_document_attachments_get and
+ * pdf_document_attachment_save, which only expose the names. The sizes,
+ * checksums and MIME types are only available to hosts that link the plugin
+ * statically.
+ *
+ * @param document Zathura document
+ * @param data Internal document representation
+ * @param error Set to an error value (see zathura_error_t) if an
+ *   error occurred
+ * @return List of pdf_attachment_info_t (owned by the document) or NULL if an
+ *   error occurred
+ */
+girara_list_t* pdf_document_attachments_get_catalogue(zathura_document_t* document, void* data,
+                                                      zathura_error_t* error);
+
 /**
  * Saves an attachment to a file
  *
@@ -117,6 +286,28 @@ girara_list_t* pdf_page_images_get(zathura_page_t* page, void* poppler_page, zat
 cairo_surface_t* pdf_page_image_get_cairo(zathura_page_t* page, void* poppler_page, zathura_image_t* image,
                                           zathura_error_t* error);
 
+/**
+ * Gets the content of the image scaled to the given size. If only one of
+ * width and height is given, the other one is chosen to keep the aspect ratio
+ * of the image on the page. The image is decoded like with
+ * pdf_page_image_get_cairo, and kept in the image cache, then reduced with an
+ * area filter or enlarged with cairo's interpolation.
+ *
+ * @param page Page
+ * @param data Internal page representation
+ * @param image Image identifier
+ * @param width Target width in pixels (0 to derive it from height)
+ * @param height Target height in pixels (0 to derive it from width)
+ * @param format CAIRO_FORMAT_ARGB32 or CAIRO_FORMAT_A8 (grayscale, stored in
+ *   the alpha channel and composited over white)
+ * @param error Set to an error value (see \ref zathura_error_t) if an
+ *   error occurred
+ * @return The cairo image surface or NULL if an error occurred
+ */
+cairo_surface_t* pdf_page_image_get_cairo_scaled(zathura_page_t* page, void* data, zathura_image_t* image,
+                                                 unsigned int width, unsigned int height, cairo_format_t format,
+                                                 zathura_error_t* error);
+
 /**
  * Returns a list of document information entries of the document
  *
@@ -128,6 +319,24 @@ cairo_surface_t* pdf_page_image_get_cairo(zathura_page_t* page, void* poppler_pa
 girara_list_t* pdf_document_get_information(zathura_document_t* document, void* poppler_document,
                                             zathura_error_t* error);
 
+/**
+ * Warms the pages following the current page in the scroll direction on a
+ * background worker: their text layout and links are extracted, so that
+ * searching, selecting and following links is fast once they are shown. The
+ * number of pages is set with ZATHURA_PDF_POPPLER_PREFETCH (default: 2, 0
+ * disables it). Pages queued by an earlier call that have not been warmed yet
+ * are dropped. Pages rendered by zathura call this with the direction in
+ * which the rendered pages moved.
+ *
+ * @param document Zathura document
+ * @param data Internal document representation
+ * @param page Index of the current page
+ * @param direction Scroll direction (negative for backwards)
+ * @return ZATHURA_ERROR_OK when no error occurred, otherwise see
+ *    zathura_error_t
+ */
+zathura_error_t pdf_document_prefetch(zathura_document_t* document, void* data, unsigned int page, int direction);
+
 /**
  * Searches for a specific text on a page and returns a list of results
  *
@@ -139,6 +348,116 @@ girara_list_t* pdf_document_get_information(zathura_document_t* document, void*
  */
 girara_list_t* pdf_page_search_text(zathura_page_t* page, void* data, const char* text, zathura_error_t* error);
 
+/**
+ * Search result of a single page
+ */
+typedef struct pdf_search_result_s {
+  unsigned int page;         /**< Page index */
+  girara_list_t* rectangles; /**< List of zathura_rectangle_t */
+} pdf_search_result_t;
+
+/**
+ * Searches for a specific text in the whole document. The pages are searched
+ * in parallel, each worker thread using its own poppler document. Only the
+ * first worker waits for a document of the pool, the others give up if none
+ * is free.
+ *
+ * zathura searches page by page through pdf_page_search_text, so this is only
+ * available to hosts that link the plugin statically.
+ *
+ * @param document Zathura document
+ * @param text Search item
+ * @param error Set to an error value (see zathura_error_t) if an
+ *   error occurred
+ * @return List of pdf_search_result_t in page order or NULL if an error
+ *   occurred
+ */
+girara_list_t* pdf_document_search_text(zathura_document_t* document, void* data, const char* text,
+                                        zathura_error_t* error);
+
+/**
+ * Receives the matches of a page during a streaming search
+ *
+ * @param page Page index
+ * @param rectangles List of zathura_rectangle_t, owned by the callback
+ * @param data User data
+ * @return false to stop the search
+ */
+typedef bool (*pdf_search_callback_t)(unsigned int page, girara_list_t* rectangles, void* data);
+
+/**
+ * Searches for a specific text in the whole document and passes the matches
+ * of every page to the callback as soon as they are found. The search starts
+ * at first_page and wraps around after the last page. Pages are delivered in
+ * that order from the calling thread, while the worker threads keep
+ * searching. Pages without matches are skipped. The function returns once
+ * the search has finished, was stopped by the callback or was cancelled.
+ *
+ * zathura searches page by page through pdf_page_search_text, so this is only
+ * available to hosts that link the plugin statically, e.g. to show the
+ * matches of an incremental search while it is typed.
+ *
+ * @param document Zathura document
+ * @param text Search item
+ * @param first_page Page searched first, usually the current page
+ * @param cancellable Cancels the search, e.g. once the query changed (may be
+ *   NULL)
+ * @param callback Function called with the matches of every page
+ * @param callback_data User data passed to callback
+ * @return ZATHURA_ERROR_OK if the search finished or was stopped by the
+ *   callback, otherwise an error value (see zathura_error_t). A cancelled
+ *   search returns ZATHURA_ERROR_UNKNOWN, callers tell it apart from a
+ *   failure with g_cancellable_is_cancelled.
+ */
+zathura_error_t pdf_document_search_text_streaming(zathura_document_t* document, void* data, const char* text,
+                                                   unsigned int first_page, GCancellable* cancellable,
+                                                   pdf_search_callback_t callback, void* callback_data);
+
+/**
+ * Options of a search term
+ */
+typedef enum pdf_search_flags_e {
+  PDF_SEARCH_DEFAULT           = 0,      /**< Case-insensitive match anywhere in the text */
+  PDF_SEARCH_CASE_SENSITIVE    = 1 << 0, /**< Match the case of the term */
+  PDF_SEARCH_WHOLE_WORD        = 1 << 1, /**< Only match whole words */
+  PDF_SEARCH_IGNORE_DIACRITICS = 1 << 2, /**< Match characters regardless of their diacritics */
+  PDF_SEARCH_REGEX             = 1 << 3, /**< The term is a regular expression (GRegex syntax) */
+} pdf_search_flags_t;
+
+/**
+ * Search term
+ */
+typedef struct pdf_search_term_s {
+  const char* text;         /**< Text or pattern to search for */
+  pdf_search_flags_t flags; /**< Options of the term */
+} pdf_search_term_t;
+
+/**
+ * Match of a search term
+ */
+typedef struct pdf_search_match_s {
+  unsigned int term;             /**< Index of the matching term */
+  zathura_rectangle_t rectangle; /**< Bounding box of the match on one line */
+} pdf_search_match_t;
+
+/**
+ * Searches for several terms at once. All plain terms are found in a single
+ * pass over the cached page text; regular expressions are matched separately.
+ * Matches of one term do not overlap, matches of different terms may.
+ * White space in terms matches any run of white space.
+ *
+ * @param page Page
+ * @param data Internal page representation
+ * @param terms Search terms
+ * @param n_terms Number of search terms
+ * @param error Set to an error value (see zathura_error_t) if an
+ *   error occurred (ZATHURA_ERROR_INVALID_ARGUMENTS for invalid patterns)
+ * @return List of pdf_search_match_t (one per line of a match) or NULL if
+ *   nothing was found or an error occurred
+ */
+girara_list_t* pdf_page_search_terms(zathura_page_t* page, void* data, const pdf_search_term_t* terms,
+                                     unsigned int n_terms, zathura_error_t* error);
+
 /**
  * Returns a list of internal/external links that are shown on the given page
  *
@@ -149,6 +468,25 @@ girara_list_t* pdf_page_search_text(zathura_page_t* page, void* data, const char
  */
 girara_list_t* pdf_page_links_get(zathura_page_t* page, void* poppler_page, zathura_error_t* error);
 
+/**
+ * Returns the links of the given page that intersect an area. The links are
+ * looked up in a grid that is built on first use and only the matching links
+ * are converted. A point can be queried with an area of zero size.
+ *
+ * zathura asks for all links of a page through pdf_page_links_get, so this is
+ * only available to hosts that link the plugin statically, e.g. to resolve
+ * the link under the pointer.
+ *
+ * @param page Page
+ * @param data Internal page representation
+ * @param area Area in page coordinates
+ * @param error Set to an error value (see zathura_error_t) if an
+ *   error occurred
+ * @return List of links (possibly empty) or NULL if an error occurred
+ */
+girara_list_t* pdf_page_links_get_at(zathura_page_t* page, void* data, zathura_rectangle_t area,
+                                     zathura_error_t* error);
+
 /**
  * Get text for selection
  * @param page Page
@@ -174,6 +512,97 @@ girara_list_t* pdf_page_get_selection(zathura_page_t* page, void* data, zathura_
  */
 zathura_error_t pdf_page_render_cairo(zathura_page_t* page, void* poppler_page, cairo_t* cairo, bool printing);
 
+/**
+ * Flags for draft rendering
+ */
+typedef enum pdf_draft_flags_e {
+  PDF_DRAFT_DEFAULT          = 0,      /**< Render annotations */
+  PDF_DRAFT_SKIP_ANNOTATIONS = 1 << 0, /**< Do not render annotations */
+} pdf_draft_flags_t;
+
+/**
+ * Renders a fast, low quality preview of a page onto a cairo object. The page
+ * is rendered without antialiasing at a fraction of the target resolution and
+ * scaled up with nearest-neighbour filtering. It is meant to be shown until a
+ * full quality render with pdf_page_render_cairo has finished. zathura does
+ * not draw previews, only hosts linking the plugin statically can use it.
+ *
+ * @param page Page
+ * @param cairo Cairo object
+ * @param flags Draft flags (see pdf_draft_flags_t)
+ * @return ZATHURA_ERROR_OK when no error occurred, otherwise see
+ *    zathura_error_t
+ */
+zathura_error_t pdf_page_render_cairo_draft(zathura_page_t* page, void* data, cairo_t* cairo,
+                                            pdf_draft_flags_t flags);
+
+/**
+ * Pixel formats of pdf_page_render_surface
+ */
+typedef enum pdf_render_format_e {
+  PDF_RENDER_FORMAT_AUTO,   /**< A8 for pages without color content, RGB24 otherwise */
+  PDF_RENDER_FORMAT_ARGB32, /**< Page content on a transparent background */
+  PDF_RENDER_FORMAT_RGB24,  /**< Page content on a white background */
+  PDF_RENDER_FORMAT_A8,     /**< Gray levels (0 is black, 255 is white) in the alpha channel */
+} pdf_render_format_t;
+
+/**
+ * Renders a page at the given scale into a new image surface of the given
+ * format. A8 surfaces need a quarter of the memory of RGB24 and ARGB32 ones.
+ * Whether a page has color content is detected on its first automatic render
+ * and remembered for the following ones. The render cache is not used.
+ *
+ * zathura always hands an ARGB32 target to page_render_cairo, so it cannot
+ * benefit from this; it is meant for hosts that link the plugin statically.
+ *
+ * @param page Page
+ * @param data Internal page representation
+ * @param scale Scale factor
+ * @param format Pixel format (see pdf_render_format_t)
+ * @param error Set to an error value (see zathura_error_t) if an
+ *   error occurred
+ * @return The image surface or NULL if an error occurred
+ */
+cairo_surface_t* pdf_page_render_surface(zathura_page_t* page, void* data, double scale, pdf_render_format_t format,
+                                         zathura_error_t* error);
+
+/**
+ * Renders a part of a page at the given scale into a new image surface. The
+ * rendering is clipped to the tile, so that the surface only covers what is
+ * requested, e.g. the visible part of a page at high zoom levels.
+ *
+ * zathura has no callback for tiles, so this is only available to hosts that
+ * link the plugin statically.
+ *
+ * @param page Page
+ * @param tile Part of the page to render in page coordinates
+ * @param scale Scale factor
+ * @param error Set to an error value (see zathura_error_t) if an
+ *   error occurred
+ * @return The image surface or NULL if an error occurred
+ */
+cairo_surface_t* pdf_page_render_tile(zathura_page_t* page, void* data, zathura_rectangle_t tile, double scale,
+                                      zathura_error_t* error);
+
+/**
+ * Returns a small image of a page for overviews. If the document embeds a
+ * thumbnail for the page, it is returned in its stored size. Otherwise the
+ * page is rendered to fit into size x size pixels. Both are kept in the
+ * document's thumbnail cache, so repeated requests are served from memory.
+ *
+ * zathura has no callback for thumbnails, so this is only available to hosts
+ * that link the plugin statically, e.g. to show an overview of the pages.
+ *
+ * @param page Page
+ * @param data Internal page representation
+ * @param size Maximal width and height of rendered thumbnails in pixels
+ * @param error Set to an error value (see zathura_error_t) if an
+ *   error occurred
+ * @return The image surface (shared with the cache, must not be drawn onto)
+ *   or NULL if an error occurred
+ */
+cairo_surface_t* pdf_page_get_thumbnail(zathura_page_t* page, void* data, unsigned int size, zathura_error_t* error);
+
 /**
  * Get the page label
  *
@@ -193,4 +622,24 @@ zathura_error_t pdf_page_get_label(zathura_page_t* page, void* data, char** labe
  */
 girara_list_t* pdf_page_get_signatures(zathura_page_t* page, void* data, zathura_error_t* error);
 
+/**
+ * Returns the signatures of a page whose validation has finished without
+ * waiting for the others. Signature fields are found and validated in the
+ * background; the results are kept for the lifetime of the document.
+ *
+ * zathura's page_get_signatures callback is blocking, it jumps the queue of
+ * the background scan instead. Polling for pending signatures is only
+ * available to hosts that link the plugin statically.
+ *
+ * @param page Page
+ * @param data Internal page representation
+ * @param pending Set to true if some signatures of the page are still being
+ *   looked up or validated
+ * @param error Set to an error value (see zathura_error_t) if an
+ *   error occurred
+ * @return List of signatures or NULL if an error occurred
+ */
+girara_list_t* pdf_page_get_signatures_nonblocking(zathura_page_t* page, void* data, bool* pending,
+                                                   zathura_error_t* error);
+
 #endif // PDF_H
@@ -0,0 +1,108 @@
+/* SPDX-License-Identifier: Zlib */
+
+#include <girara/log.h>
+
+#include "pool.h"
+
+void pdf_document_pool_init(pdf_document_t* pdf_document) {
+  g_queue_init(&pdf_document->pool.idle);
+  pdf_document->pool.size = 0;
+  g_mutex_init(&pdf_document->pool.lock);
+  g_cond_init(&pdf_document->pool.cond);
+}
+
+void pdf_document_pool_clear(pdf_document_t* pdf_document) {
+  g_queue_clear_full(&pdf_document->pool.idle, g_object_unref);
+  pdf_document->pool.size = 0;
+  g_mutex_clear(&pdf_document->pool.lock);
+  g_cond_clear(&pdf_document->pool.cond);
+}
+
+unsigned int pdf_document_pool_max_size(void) {
+  return MAX(1, g_get_num_processors());
+}
+
+PopplerDocument* pdf_document_open_poppler_document(pdf_document_t* pdf_document, GError** error) {
+  if (pdf_document->mapping != NULL) {
+    GBytes* bytes                     = g_mapped_file_get_bytes(pdf_document->mapping);
+    PopplerDocument* poppler_document = poppler_document_new_from_bytes(bytes, pdf_document->password, error);
+    g_bytes_unref(bytes);
+    return poppler_document;
+  }
+
+  char* file_uri = g_filename_to_uri(pdf_document->path, NULL, error);
+  if (file_uri == NULL) {
+    return NULL;
+  }
+
+  PopplerDocument* poppler_document = poppler_document_new_from_file(file_uri, pdf_document->password, error);
+  g_free(file_uri);
+
+  return poppler_document;
+}
+
+static PopplerDocument* pool_open_document(pdf_document_t* pdf_document) {
+  GError* gerror                    = NULL;
+  PopplerDocument* poppler_document = pdf_document_open_poppler_document(pdf_document, &gerror);
+  if (poppler_document == NULL) {
+    girara_warning("Failed to open secondary document: %s", gerror != NULL ? gerror->message : "unknown error");
+    g_clear_error(&gerror);
+  }
+
+  return poppler_document;
+}
+
+static PopplerDocument* pool_acquire(pdf_document_t* pdf_document, bool wait) {
+  if (pdf_document == NULL) {
+    return NULL;
+  }
+
+  g_mutex_lock(&pdf_document->pool.lock);
+  while (g_queue_is_empty(&pdf_document->pool.idle) == TRUE &&
+         pdf_document->pool.size >= pdf_document_pool_max_size()) {
+    if (wait == false) {
+      g_mutex_unlock(&pdf_document->pool.lock);
+      return NULL;
+    }
+    g_cond_wait(&pdf_document->pool.cond, &pdf_document->pool.lock);
+  }
+
+  PopplerDocument* poppler_document = g_queue_pop_head(&pdf_document->pool.idle);
+  if (poppler_document != NULL) {
+    g_mutex_unlock(&pdf_document->pool.lock);
+    return poppler_document;
+  }
+
+  /* open a new instance outside of the lock */
+  pdf_document->pool.size++;
+  g_mutex_unlock(&pdf_document->pool.lock);
+
+  poppler_document = pool_open_document(pdf_document);
+  if (poppler_document == NULL) {
+    g_mutex_lock(&pdf_document->pool.lock);
+    pdf_document->pool.size--;
+    g_cond_signal(&pdf_document->pool.cond);
+    g_mutex_unlock(&pdf_document->pool.lock);
+  }
+
+  return poppler_document;
+}
+
+PopplerDocument* pdf_document_pool_acquire(pdf_document_t* pdf_document) {
+  return pool_acquire(pdf_document, true);
+}
+
+PopplerDocument* pdf_document_pool_try_acquire(pdf_document_t* pdf_document) {
+  return pool_acquire(pdf_document, false);
+}
+
+void pdf_document_pool_release(pdf_document_t* pdf_document, PopplerDocument* poppler_document) {
+  if (pdf_document == NULL || poppler_document == NULL) {
+    return;
+  }
+
+  g_mutex_lock(&pdf_document->pool.lock);
+  g_queue_push_head(&pdf_document->pool.idle, poppler_document);
+  g_cond_signal(&pdf_document->pool.cond);
+  g_mutex_unlock(&pdf_document->pool.lock);
+}
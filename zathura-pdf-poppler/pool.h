@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: Zlib */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "plugin.h"
+
+/**
+ * Environment variable that enables opening documents from a memory mapping
+ */
+#define PDF_MMAP_ENV "ZATHURA_PDF_POPPLER_MMAP"
+
+/**
+ * Opens a new poppler document instance of the document's file. If the file
+ * is memory mapped, the instance is created from the shared mapping.
+ *
+ * @param pdf_document The document
+ * @param error Set if an error occurred
+ * @return Poppler document or NULL if an error occurred
+ */
+PopplerDocument* pdf_document_open_poppler_document(pdf_document_t* pdf_document, GError** error);
+
+/**
+ * Initializes the pool of secondary poppler documents
+ *
+ * @param pdf_document The document
+ */
+void pdf_document_pool_init(pdf_document_t* pdf_document);
+
+/**
+ * Frees all secondary poppler documents of the pool
+ *
+ * @param pdf_document The document
+ */
+void pdf_document_pool_clear(pdf_document_t* pdf_document);
+
+/**
+ * Returns the maximal number of secondary poppler documents
+ *
+ * @return Number of documents
+ */
+unsigned int pdf_document_pool_max_size(void);
+
+/**
+ * Acquires a secondary poppler document opened from the same file. Poppler
+ * documents are not safe for concurrent use, so every worker thread acquires
+ * its own instance. Blocks if all instances are in use.
+ *
+ * @param pdf_document The document
+ * @return Poppler document or NULL if an error occurred
+ */
+PopplerDocument* pdf_document_pool_acquire(pdf_document_t* pdf_document);
+
+/**
+ * Acquires a secondary poppler document like pdf_document_pool_acquire, but
+ * returns NULL instead of blocking if all instances are in use
+ *
+ * @param pdf_document The document
+ * @return Poppler document or NULL if none is free or an error occurred
+ */
+PopplerDocument* pdf_document_pool_try_acquire(pdf_document_t* pdf_document);
+
+/**
+ * Releases a poppler document acquired with pdf_document_pool_acquire
+ *
+ * @param pdf_document The document
+ * @param poppler_document The poppler document
+ */
+void pdf_document_pool_release(pdf_document_t* pdf_document, PopplerDocument* poppler_document);
+
+#endif // POOL_H
@@ -0,0 +1,222 @@
+/* SPDX-License-Identifier: Zlib */
+
+#include "plugin.h"
+#include "links.h"
+#include "pool.h"
+#include "prefetch.h"
+#include "text.h"
+
+/* Page to warm */
+typedef struct prefetch_task_s {
+  pdf_page_t* pdf_page;  /* The page */
+  unsigned int priority; /* Distance from the current page, lower runs first */
+  guint generation;      /* Generation of the scheduler when the task was queued */
+} prefetch_task_t;
+
+struct pdf_prefetch_s {
+  pdf_document_t* pdf_document;
+  unsigned int distance;
+  GThreadPool* worker;
+
+  GMutex lock;
+  GCond cond;
+  guint generation;       /* Tasks of older generations are dropped */
+  unsigned int queued;    /* Queued tasks of the current generation */
+  bool running;           /* Whether the worker is warming a page */
+  bool rendered;          /* Whether a page has been rendered yet */
+  unsigned int last_page; /* Index of the last rendered page */
+};
+
+static bool page_is_warm(pdf_page_t* pdf_page) {
+  g_mutex_lock(&pdf_page->lock);
+  const bool warm = pdf_page->text != NULL && pdf_page->links != NULL;
+  g_mutex_unlock(&pdf_page->lock);
+
+  return warm;
+}
+
+/* Tasks of older generations go first since they are stale and only free themselves, then the ones closest to the
+ * current page */
+static gint prefetch_task_compare(gconstpointer a, gconstpointer b, gpointer user_data) {
+  const prefetch_task_t* lhs = a;
+  const prefetch_task_t* rhs = b;
+  (void)user_data;
+
+  if (lhs->generation != rhs->generation) {
+    return (gint)(lhs->generation - rhs->generation);
+  }
+
+  return lhs->priority < rhs->priority ? -1 : (lhs->priority > rhs->priority ? 1 : 0);
+}
+
+static void prefetch_run(gpointer data, gpointer user_data) {
+  prefetch_task_t* task    = data;
+  pdf_prefetch_t* prefetch = user_data;
+
+  /* the page may only be touched while it is marked as running, pdf_prefetch_cancel waits for that */
+  g_mutex_lock(&prefetch->lock);
+  const bool current = task->generation == prefetch->generation;
+  prefetch->running  = current;
+  if (current == true) {
+    prefetch->queued--;
+  }
+  g_mutex_unlock(&prefetch->lock);
+
+  if (current == true) {
+    pdf_document_t* pdf_document = prefetch->pdf_document;
+    pdf_page_t* pdf_page         = task->pdf_page;
+
+    if (page_is_warm(pdf_page) == false) {
+      PopplerDocument* poppler_document = pdf_document_pool_acquire(pdf_document);
+      if (poppler_document != NULL) {
+        pdf_text_unref(pdf_page_get_text_layout_from(pdf_page, poppler_document, pdf_page->index, true));
+        pdf_page_get_link_index_from(pdf_page, poppler_document);
+        pdf_document_pool_release(pdf_document, poppler_document);
+      }
+    }
+
+    g_mutex_lock(&prefetch->lock);
+    prefetch->running = false;
+    g_cond_broadcast(&prefetch->cond);
+    g_mutex_unlock(&prefetch->lock);
+  }
+
+  g_free(task);
+}
+
+pdf_prefetch_t* pdf_prefetch_new(pdf_document_t* pdf_document, unsigned int distance) {
+  if (distance == 0) {
+    return NULL;
+  }
+
+  pdf_prefetch_t* prefetch = g_try_malloc0(sizeof(pdf_prefetch_t));
+  if (prefetch == NULL) {
+    return NULL;
+  }
+
+  prefetch->worker = g_thread_pool_new(prefetch_run, prefetch, 1, FALSE, NULL);
+  if (prefetch->worker == NULL) {
+    g_free(prefetch);
+    return NULL;
+  }
+  g_thread_pool_set_sort_function(prefetch->worker, prefetch_task_compare, NULL);
+
+  prefetch->pdf_document = pdf_document;
+  prefetch->distance     = distance;
+  g_mutex_init(&prefetch->lock);
+  g_cond_init(&prefetch->cond);
+
+  return prefetch;
+}
+
+void pdf_prefetch_cancel(pdf_prefetch_t* prefetch) {
+  if (prefetch == NULL) {
+    return;
+  }
+
+  g_mutex_lock(&prefetch->lock);
+  prefetch->generation++;
+  prefetch->queued = 0;
+  while (prefetch->running == true) {
+    g_cond_wait(&prefetch->cond, &prefetch->lock);
+  }
+  g_mutex_unlock(&prefetch->lock);
+}
+
+void pdf_prefetch_free(pdf_prefetch_t* prefetch) {
+  if (prefetch == NULL) {
+    return;
+  }
+
+  /* the queued tasks are stale after the cancellation and only free themselves */
+  pdf_prefetch_cancel(prefetch);
+  g_thread_pool_free(prefetch->worker, FALSE, TRUE);
+
+  g_cond_clear(&prefetch->cond);
+  g_mutex_clear(&prefetch->lock);
+  g_free(prefetch);
+}
+
+zathura_error_t pdf_document_prefetch(zathura_document_t* document, void* data, unsigned int page, int direction) {
+  if (document == NULL || data == NULL) {
+    return ZATHURA_ERROR_INVALID_ARGUMENTS;
+  }
+
+  pdf_document_t* pdf_document = data;
+  pdf_prefetch_t* prefetch     = pdf_document->prefetch;
+  if (prefetch == NULL) {
+    return ZATHURA_ERROR_OK;
+  }
+
+  /* a new viewport replaces the pages queued for the previous one, which no longer count against the limit */
+  g_mutex_lock(&prefetch->lock);
+  const guint generation = ++prefetch->generation;
+  prefetch->queued       = 0;
+  g_mutex_unlock(&prefetch->lock);
+
+  for (unsigned int n = 1; n <= prefetch->distance; ++n) {
+    if (direction < 0 ? n > page : page + n >= pdf_document->number_of_pages) {
+      break;
+    }
+
+    const unsigned int index = direction < 0 ? page - n : page + n;
+    zathura_page_t* next     = zathura_document_get_page(document, index);
+    pdf_page_t* pdf_page     = next != NULL ? zathura_page_get_data(next) : NULL;
+    if (pdf_page == NULL || page_is_warm(pdf_page) == true) {
+      continue;
+    }
+
+    prefetch_task_t* task = g_try_malloc0(sizeof(prefetch_task_t));
+    if (task == NULL) {
+      return ZATHURA_ERROR_OUT_OF_MEMORY;
+    }
+
+    task->pdf_page   = pdf_page;
+    task->priority   = n;
+    task->generation = generation;
+
+    /* a later call may have started a new generation meanwhile, its tasks take precedence */
+    g_mutex_lock(&prefetch->lock);
+    const bool queue = prefetch->generation == generation && prefetch->queued < PDF_PREFETCH_MAX_IN_FLIGHT;
+    if (queue == true) {
+      prefetch->queued++;
+    }
+    g_mutex_unlock(&prefetch->lock);
+
+    if (queue == false) {
+      g_free(task);
+      break;
+    }
+
+    if (g_thread_pool_push(prefetch->worker, task, NULL) == FALSE) {
+      g_mutex_lock(&prefetch->lock);
+      if (prefetch->generation == generation) {
+        prefetch->queued--;
+      }
+      g_mutex_unlock(&prefetch->lock);
+      g_free(task);
+      return ZATHURA_ERROR_UNKNOWN;
+    }
+  }
+
+  return ZATHURA_ERROR_OK;
+}
+
+void pdf_prefetch_page_rendered(zathura_page_t* page, pdf_page_t* pdf_page) {
+  pdf_prefetch_t* prefetch = pdf_page->document->prefetch;
+  if (prefetch == NULL) {
+    return;
+  }
+
+  /* redraws of the same page keep the queued pages */
+  g_mutex_lock(&prefetch->lock);
+  const bool changed  = prefetch->rendered == false || prefetch->last_page != pdf_page->index;
+  const int direction = prefetch->rendered == true && pdf_page->index < prefetch->last_page ? -1 : 1;
+  prefetch->rendered  = true;
+  prefetch->last_page = pdf_page->index;
+  g_mutex_unlock(&prefetch->lock);
+
+  if (changed == true) {
+    pdf_document_prefetch(zathura_page_get_document(page), pdf_page->document, pdf_page->index, direction);
+  }
+}
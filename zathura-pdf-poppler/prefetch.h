@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: Zlib */
+
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include "plugin.h"
+
+/**
+ * Environment variable with the number of pages warmed ahead of the current
+ * page (0 disables the prefetching)
+ */
+#define PDF_PREFETCH_ENV "ZATHURA_PDF_POPPLER_PREFETCH"
+
+/**
+ * Default number of pages warmed ahead of the current page
+ */
+#define PDF_PREFETCH_DEFAULT 2
+
+/**
+ * Maximal number of queued prefetch tasks of the latest request
+ */
+#define PDF_PREFETCH_MAX_IN_FLIGHT 32
+
+typedef struct pdf_prefetch_s pdf_prefetch_t;
+
+/**
+ * Creates the prefetch scheduler of a document. Pages are warmed one at a time
+ * on a background worker that uses a secondary poppler document of the pool.
+ *
+ * @param pdf_document The document
+ * @param distance Number of pages warmed ahead of the current page
+ * @return Prefetch scheduler or NULL if distance is 0 or an error occurred
+ */
+pdf_prefetch_t* pdf_prefetch_new(pdf_document_t* pdf_document, unsigned int distance);
+
+/**
+ * Cancels all prefetch tasks and frees the scheduler
+ *
+ * @param prefetch The prefetch scheduler (may be NULL)
+ */
+void pdf_prefetch_free(pdf_prefetch_t* prefetch);
+
+/**
+ * Drops all queued prefetch tasks and waits for the running one to finish.
+ * Needs to be called before pages are freed.
+ *
+ * @param prefetch The prefetch scheduler (may be NULL)
+ */
+void pdf_prefetch_cancel(pdf_prefetch_t* prefetch);
+
+/**
+ * Warms the pages following a page that zathura has rendered. The scroll
+ * direction is inferred from the previously rendered page; redraws of the
+ * same page do not replace the queued pages.
+ *
+ * @param page The rendered page
+ * @param pdf_page Internal page representation
+ */
+void pdf_prefetch_page_rendered(zathura_page_t* page, pdf_page_t* pdf_page);
+
+#endif // PREFETCH_H
@@ -1,18 +1,450 @@
 /* SPDX-License-Identifier: Zlib */
 
+#include <math.h>
+#include <string.h>
+
 #include "plugin.h"
+#include "cache.h"
+#include "page.h"
+#include "prefetch.h"
 
-zathura_error_t pdf_page_render_cairo(zathura_page_t* page, void* data, cairo_t* cairo, bool printing) {
-  if (page == NULL || data == NULL || cairo == NULL) {
-    return ZATHURA_ERROR_INVALID_ARGUMENTS;
-  }
+/* Draft renders use a fraction of the target resolution */
+#define PDF_DRAFT_DOWNSCALE 2
+
+/* Values of pdf_page_t.color */
+enum {
+  PDF_PAGE_COLOR_UNKNOWN = 0,
+  PDF_PAGE_COLOR_GRAY,
+  PDF_PAGE_COLOR_COLOR,
+};
+
+/* Keys of thumbnails in the thumbnail cache. Size 0 stands for the embedded thumbnail. */
+typedef struct thumbnail_key_s {
+  unsigned int page;
+  unsigned int size;
+} thumbnail_key_t;
+
+typedef struct render_key_s {
+  unsigned int page;
+  int width;
+  int height;
+  int format;
+  int printing;
+  guint32 background;
+  double matrix[6];
+} render_key_t;
 
-  PopplerPage* poppler_page = data;
+static void render_poppler_page(PopplerPage* poppler_page, cairo_t* cairo, bool printing) {
   if (printing == false) {
     poppler_page_render(poppler_page, cairo);
   } else {
     poppler_page_render_for_printing(poppler_page, cairo);
   }
+}
+
+static zathura_error_t render_page(pdf_page_t* pdf_page, cairo_t* cairo, bool printing) {
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+  if (poppler_page == NULL) {
+    return ZATHURA_ERROR_UNKNOWN;
+  }
+
+  render_poppler_page(poppler_page, cairo, printing);
+  g_object_unref(poppler_page);
+
+  return ZATHURA_ERROR_OK;
+}
+
+/* Checks whether the clip of the context covers the whole target, i.e. whether rendering replaces all of it */
+static bool render_covers_target(cairo_t* cairo, int width, int height) {
+  double x1 = 0;
+  double y1 = 0;
+  double x2 = 0;
+  double y2 = 0;
+
+  cairo_save(cairo);
+  cairo_identity_matrix(cairo);
+  cairo_clip_extents(cairo, &x1, &y1, &x2, &y2);
+  cairo_restore(cairo);
+
+  return x1 <= 0 && y1 <= 0 && x2 >= width && y2 >= height;
+}
+
+/* Copies an image surface into a new surface of the same format */
+static cairo_surface_t* copy_surface(cairo_surface_t* source, cairo_format_t format, int width, int height) {
+  cairo_surface_t* surface = cairo_image_surface_create(format, width, height);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    return NULL;
+  }
+
+  cairo_t* cairo = cairo_create(surface);
+  cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_surface(cairo, source, 0, 0);
+  cairo_paint(cairo);
+  cairo_destroy(cairo);
+
+  return surface;
+}
+
+/*
+ * Pages are rendered directly into the target and a copy of the result is cached, so a miss costs no more memory
+ * than the cached page itself. The copy already contains the background the host painted before rendering, hence
+ * the key includes the color of the first pixel (hosts paint a uniform background), and targets that are only
+ * partially drawn to, or whose format cannot be copied cheaply, are not cached.
+ */
+static zathura_error_t render_page_cached(pdf_page_t* pdf_page, cairo_t* cairo, bool printing) {
+  /* only raster targets are cached, vector targets (e.g. printing to PDF) are rendered directly */
+  cairo_surface_t* target = cairo_get_target(cairo);
+  pdf_cache_t* cache      = pdf_page->document->render_cache;
+  if (cache == NULL || cairo_surface_get_type(target) != CAIRO_SURFACE_TYPE_IMAGE) {
+    return render_page(pdf_page, cairo, printing);
+  }
+
+  const cairo_format_t format = cairo_image_surface_get_format(target);
+  const int width             = cairo_image_surface_get_width(target);
+  const int height            = cairo_image_surface_get_height(target);
+  if ((format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24) || width <= 0 || height <= 0 ||
+      render_covers_target(cairo, width, height) == false) {
+    return render_page(pdf_page, cairo, printing);
+  }
+
+  /* the transformation captures scale and rotation */
+  cairo_matrix_t matrix;
+  cairo_get_matrix(cairo, &matrix);
+
+  cairo_surface_flush(target);
+
+  render_key_t key;
+  memset(&key, 0, sizeof(key));
+  key.page       = pdf_page->index;
+  key.width      = width;
+  key.height     = height;
+  key.format     = format;
+  key.printing   = printing;
+  key.background = *(const guint32*)cairo_image_surface_get_data(target);
+  key.matrix[0]  = matrix.xx;
+  key.matrix[1]  = matrix.yx;
+  key.matrix[2]  = matrix.xy;
+  key.matrix[3]  = matrix.yy;
+  key.matrix[4]  = matrix.x0;
+  key.matrix[5]  = matrix.y0;
+
+  cairo_surface_t* surface = pdf_cache_lookup(cache, &key, sizeof(key));
+  if (surface != NULL) {
+    cairo_save(cairo);
+    cairo_identity_matrix(cairo);
+    cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_surface(cairo, surface, 0, 0);
+    cairo_paint(cairo);
+    cairo_restore(cairo);
+
+    cairo_surface_destroy(surface);
+    return ZATHURA_ERROR_OK;
+  }
+
+  const zathura_error_t error = render_page(pdf_page, cairo, printing);
+  if (error != ZATHURA_ERROR_OK) {
+    return error;
+  }
+
+  /* without memory for the copy, the page is still rendered, it is just not cached */
+  surface = copy_surface(target, format, width, height);
+  if (surface != NULL) {
+    pdf_cache_insert(cache, &key, sizeof(key), surface);
+    cairo_surface_destroy(surface);
+  }
+
+  return ZATHURA_ERROR_OK;
+}
+
+zathura_error_t pdf_page_render_cairo(zathura_page_t* page, void* data, cairo_t* cairo, bool printing) {
+  if (page == NULL || data == NULL || cairo == NULL) {
+    return ZATHURA_ERROR_INVALID_ARGUMENTS;
+  }
+
+  const zathura_error_t error = render_page_cached(data, cairo, printing);
+  if (error == ZATHURA_ERROR_OK && printing == false) {
+    pdf_prefetch_page_rendered(page, data);
+  }
+
+  return error;
+}
+
+cairo_surface_t* pdf_page_render_tile(zathura_page_t* page, void* data, zathura_rectangle_t tile, double scale,
+                                      zathura_error_t* error) {
+  if (page == NULL || data == NULL || scale <= 0 || tile.x2 <= tile.x1 || tile.y2 <= tile.y1) {
+    zathura_check_set_error(error, ZATHURA_ERROR_INVALID_ARGUMENTS);
+    return NULL;
+  }
+
+  const int width  = ceil((tile.x2 - tile.x1) * scale);
+  const int height = ceil((tile.y2 - tile.y1) * scale);
+
+  cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+    return NULL;
+  }
+
+  cairo_t* cairo = cairo_create(surface);
+  cairo_set_source_rgb(cairo, 1, 1, 1);
+  cairo_paint(cairo);
+
+  /* everything outside of the tile is clipped before it is rasterized */
+  cairo_rectangle(cairo, 0, 0, width, height);
+  cairo_clip(cairo);
+  cairo_scale(cairo, scale, scale);
+  cairo_translate(cairo, -tile.x1, -tile.y1);
+
+  /* tiles are rarely requested twice, they bypass the render cache */
+  const zathura_error_t ret = render_page(data, cairo, false);
+  cairo_destroy(cairo);
+
+  if (ret != ZATHURA_ERROR_OK) {
+    cairo_surface_destroy(surface);
+    zathura_check_set_error(error, ret);
+    return NULL;
+  }
+
+  return surface;
+}
+
+cairo_surface_t* pdf_page_get_thumbnail(zathura_page_t* page, void* data, unsigned int size, zathura_error_t* error) {
+  if (page == NULL || data == NULL || size == 0) {
+    zathura_check_set_error(error, ZATHURA_ERROR_INVALID_ARGUMENTS);
+    return NULL;
+  }
+
+  pdf_page_t* pdf_page         = data;
+  pdf_document_t* pdf_document = pdf_page->document;
+  pdf_cache_t* cache           = pdf_document->thumbnail_cache;
+
+  thumbnail_key_t embedded_key = {.page = pdf_page->index, .size = 0};
+  thumbnail_key_t key          = {.page = pdf_page->index, .size = size};
+
+  /* the cached surfaces are shared, callers must not draw onto them */
+  cairo_surface_t* surface = pdf_cache_lookup(cache, &embedded_key, sizeof(embedded_key));
+  if (surface == NULL) {
+    surface = pdf_cache_lookup(cache, &key, sizeof(key));
+  }
+  if (surface != NULL) {
+    return surface;
+  }
+
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+  if (poppler_page == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
+    return NULL;
+  }
+
+  surface = poppler_page_get_thumbnail(poppler_page);
+  if (surface != NULL && cairo_surface_get_type(surface) == CAIRO_SURFACE_TYPE_IMAGE) {
+    g_object_unref(poppler_page);
+    pdf_cache_insert(cache, &embedded_key, sizeof(embedded_key), surface);
+    return surface;
+  }
+  if (surface != NULL) {
+    cairo_surface_destroy(surface);
+  }
+
+  /* without an embedded thumbnail, the page is rendered to fit into size x size pixels */
+  const double page_width  = pdf_document->geometry[pdf_page->index].width;
+  const double page_height = pdf_document->geometry[pdf_page->index].height;
+  const double scale       = size / MAX(1, MAX(page_width, page_height));
+  const int width          = MAX(1, ceil(page_width * scale));
+  const int height         = MAX(1, ceil(page_height * scale));
+
+  surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    g_object_unref(poppler_page);
+    zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+    return NULL;
+  }
+
+  cairo_t* cairo = cairo_create(surface);
+  cairo_set_source_rgb(cairo, 1, 1, 1);
+  cairo_paint(cairo);
+  cairo_scale(cairo, scale, scale);
+  render_poppler_page(poppler_page, cairo, false);
+  cairo_destroy(cairo);
+  g_object_unref(poppler_page);
+
+  pdf_cache_insert(cache, &key, sizeof(key), surface);
+  return surface;
+}
+
+/*
+ * Converts an RGB24 surface into an A8 surface. If check is true, the conversion stops at the first pixel that is
+ * not gray and NULL is returned.
+ */
+static cairo_surface_t* convert_to_gray(cairo_surface_t* source, bool check) {
+  const int width  = cairo_image_surface_get_width(source);
+  const int height = cairo_image_surface_get_height(source);
+
+  cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_A8, width, height);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    return NULL;
+  }
+
+  cairo_surface_flush(source);
+  const int source_stride      = cairo_image_surface_get_stride(source);
+  const unsigned char* sources = cairo_image_surface_get_data(source);
+  const int stride             = cairo_image_surface_get_stride(surface);
+  unsigned char* targets       = cairo_image_surface_get_data(surface);
+
+  for (int y = 0; y < height; ++y) {
+    const guint32* row = (const guint32*)(sources + (gsize)y * source_stride);
+    unsigned char* out = targets + (gsize)y * stride;
+    for (int x = 0; x < width; ++x) {
+      const guint32 r = (row[x] >> 16) & 0xff;
+      const guint32 g = (row[x] >> 8) & 0xff;
+      const guint32 b = row[x] & 0xff;
+      if (check == true && (r != g || g != b)) {
+        cairo_surface_destroy(surface);
+        return NULL;
+      }
+      out[x] = (77 * r + 150 * g + 29 * b) >> 8;
+    }
+  }
+
+  cairo_surface_mark_dirty(surface);
+  return surface;
+}
+
+cairo_surface_t* pdf_page_render_surface(zathura_page_t* page, void* data, double scale, pdf_render_format_t format,
+                                         zathura_error_t* error) {
+  if (page == NULL || data == NULL || scale <= 0) {
+    zathura_check_set_error(error, ZATHURA_ERROR_INVALID_ARGUMENTS);
+    return NULL;
+  }
+
+  pdf_page_t* pdf_page         = data;
+  pdf_document_t* pdf_document = pdf_page->document;
+
+  const int width  = MAX(1, ceil(pdf_document->geometry[pdf_page->index].width * scale));
+  const int height = MAX(1, ceil(pdf_document->geometry[pdf_page->index].height * scale));
+
+  /* gray pages are rendered in RGB24 and converted afterwards, poppler cannot draw into A8 surfaces */
+  const gint color = g_atomic_int_get(&pdf_page->color);
+  if (format == PDF_RENDER_FORMAT_AUTO && color == PDF_PAGE_COLOR_GRAY) {
+    format = PDF_RENDER_FORMAT_A8;
+  }
+
+  cairo_surface_t* surface =
+      cairo_image_surface_create(format == PDF_RENDER_FORMAT_ARGB32 ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24,
+                                 width, height);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+    return NULL;
+  }
+
+  cairo_t* cairo = cairo_create(surface);
+  if (format != PDF_RENDER_FORMAT_ARGB32) {
+    cairo_set_source_rgb(cairo, 1, 1, 1);
+    cairo_paint(cairo);
+  }
+  cairo_scale(cairo, scale, scale);
+
+  /* the surface is handed to the caller, caching a copy of it would only double the memory */
+  const zathura_error_t ret = render_page(data, cairo, false);
+  cairo_destroy(cairo);
+
+  if (ret != ZATHURA_ERROR_OK) {
+    cairo_surface_destroy(surface);
+    zathura_check_set_error(error, ret);
+    return NULL;
+  }
+
+  if (format == PDF_RENDER_FORMAT_A8 || (format == PDF_RENDER_FORMAT_AUTO && color == PDF_PAGE_COLOR_UNKNOWN)) {
+    const bool check      = format == PDF_RENDER_FORMAT_AUTO;
+    cairo_surface_t* gray = convert_to_gray(surface, check);
+    if (check == true) {
+      g_atomic_int_set(&pdf_page->color, gray != NULL ? PDF_PAGE_COLOR_GRAY : PDF_PAGE_COLOR_COLOR);
+    }
+    if (gray != NULL) {
+      cairo_surface_destroy(surface);
+      surface = gray;
+    } else if (check == false) {
+      cairo_surface_destroy(surface);
+      zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+      return NULL;
+    }
+  }
+
+  return surface;
+}
+
+static void render_page_draft(PopplerPage* poppler_page, cairo_t* cairo, pdf_draft_flags_t flags) {
+  cairo_set_antialias(cairo, CAIRO_ANTIALIAS_NONE);
+
+  cairo_font_options_t* font_options = cairo_font_options_create();
+  cairo_font_options_set_antialias(font_options, CAIRO_ANTIALIAS_NONE);
+  cairo_set_font_options(cairo, font_options);
+  cairo_font_options_destroy(font_options);
+
+#if POPPLER_CHECK_VERSION(22, 2, 0)
+  const PopplerRenderAnnotsFlags annots =
+      (flags & PDF_DRAFT_SKIP_ANNOTATIONS) != 0 ? POPPLER_RENDER_ANNOTS_NONE : POPPLER_RENDER_ANNOTS_ALL;
+  poppler_page_render_full(poppler_page, cairo, FALSE, annots);
+#else
+  (void)flags;
+  poppler_page_render(poppler_page, cairo);
+#endif
+}
+
+zathura_error_t pdf_page_render_cairo_draft(zathura_page_t* page, void* data, cairo_t* cairo,
+                                            pdf_draft_flags_t flags) {
+  if (page == NULL || data == NULL || cairo == NULL) {
+    return ZATHURA_ERROR_INVALID_ARGUMENTS;
+  }
+
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(data);
+  if (poppler_page == NULL) {
+    return ZATHURA_ERROR_UNKNOWN;
+  }
+
+  /* only raster targets can be rendered at a lower resolution */
+  cairo_surface_t* target = cairo_get_target(cairo);
+  if (cairo_surface_get_type(target) != CAIRO_SURFACE_TYPE_IMAGE) {
+    cairo_save(cairo);
+    render_page_draft(poppler_page, cairo, flags);
+    cairo_restore(cairo);
+    g_object_unref(poppler_page);
+    return ZATHURA_ERROR_OK;
+  }
+
+  const int width  = MAX(1, cairo_image_surface_get_width(target) / PDF_DRAFT_DOWNSCALE);
+  const int height = MAX(1, cairo_image_surface_get_height(target) / PDF_DRAFT_DOWNSCALE);
+
+  cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    g_object_unref(poppler_page);
+    return ZATHURA_ERROR_OUT_OF_MEMORY;
+  }
+
+  cairo_matrix_t matrix;
+  cairo_get_matrix(cairo, &matrix);
+
+  cairo_t* surface_cairo = cairo_create(surface);
+  cairo_scale(surface_cairo, 1.0 / PDF_DRAFT_DOWNSCALE, 1.0 / PDF_DRAFT_DOWNSCALE);
+  cairo_transform(surface_cairo, &matrix);
+  render_page_draft(poppler_page, surface_cairo, flags);
+  cairo_destroy(surface_cairo);
+  g_object_unref(poppler_page);
+
+  cairo_save(cairo);
+  cairo_identity_matrix(cairo);
+  cairo_scale(cairo, PDF_DRAFT_DOWNSCALE, PDF_DRAFT_DOWNSCALE);
+  cairo_set_source_surface(cairo, surface, 0, 0);
+  cairo_pattern_set_filter(cairo_get_source(cairo), CAIRO_FILTER_NEAREST);
+  cairo_paint(cairo);
+  cairo_restore(cairo);
 
+  cairo_surface_destroy(surface);
   return ZATHURA_ERROR_OK;
 }
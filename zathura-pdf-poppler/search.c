@@ -3,9 +3,153 @@
 #include <string.h>
 
 #include "plugin.h"
+#include "automaton.h"
+#include "fulltext.h"
+#include "pool.h"
+#include "text.h"
 
-static void rectangle_free(void* data) {
-  poppler_rectangle_free(data);
+/* Folds a search text like the cached page text. If upper is not NULL, it receives whether every character was
+ * changed by case folding. */
+static gunichar* fold_search_text(const char* text, guint* length, guint8** upper) {
+  const glong n_characters = g_utf8_strlen(text, -1);
+  gunichar* characters     = g_try_malloc_n(n_characters + 1, sizeof(gunichar));
+  guint8* folded           = upper != NULL ? g_try_malloc0_n(n_characters + 1, sizeof(guint8)) : NULL;
+  if (characters == NULL || (upper != NULL && folded == NULL)) {
+    g_free(characters);
+    g_free(folded);
+    return NULL;
+  }
+
+  /* fold the same way as the cached page text and collapse white space */
+  guint n = 0;
+  for (const char* p = text; *p != '\0'; p = g_utf8_next_char(p)) {
+    const gunichar c = g_utf8_get_char(p);
+    if (g_unichar_isspace(c) == TRUE) {
+      if (n == 0 || characters[n - 1] != ' ') {
+        characters[n++] = ' ';
+      }
+    } else {
+      characters[n] = g_unichar_tolower(c);
+      if (folded != NULL) {
+        folded[n] = characters[n] != c;
+      }
+      ++n;
+    }
+  }
+  characters[n] = 0;
+
+  *length = n;
+  if (upper != NULL) {
+    *upper = folded;
+  }
+  return characters;
+}
+
+static guint match_at(pdf_text_t* text, guint offset, const gunichar* needle, guint needle_length) {
+  guint i = offset;
+  for (guint j = 0; j < needle_length; ++j) {
+    if (i >= text->length) {
+      return 0;
+    }
+
+    if (needle[j] == ' ') {
+      /* white space matches any run of white space, including line breaks */
+      if (text->characters[i] != ' ') {
+        return 0;
+      }
+      while (i < text->length && text->characters[i] == ' ') {
+        ++i;
+      }
+    } else if (text->characters[i++] != needle[j]) {
+      return 0;
+    }
+  }
+
+  return i - offset;
+}
+
+/* Called with the bounding box of every line of a match */
+typedef bool (*match_line_func_t)(const zathura_rectangle_t* rectangle, void* data);
+
+static bool foreach_match_line(pdf_text_t* text, guint start, guint end, match_line_func_t func, void* data) {
+  zathura_rectangle_t rectangle = {0, 0, 0, 0};
+  bool open                     = false;
+
+  for (guint i = start; i < end; ++i) {
+    if (text->characters[i] == ' ') {
+      continue;
+    }
+
+    const pdf_text_rectangle_t* glyph = &text->rectangles[i];
+    /* start a new rectangle for every line the match spans */
+    if (open == true && (glyph->y1 >= rectangle.y2 || glyph->y2 <= rectangle.y1)) {
+      if (func(&rectangle, data) == false) {
+        return false;
+      }
+      open = false;
+    }
+
+    if (open == false) {
+      rectangle.x1 = glyph->x1;
+      rectangle.x2 = glyph->x2;
+      rectangle.y1 = glyph->y1;
+      rectangle.y2 = glyph->y2;
+      open         = true;
+    } else {
+      rectangle.x1 = MIN(rectangle.x1, glyph->x1);
+      rectangle.x2 = MAX(rectangle.x2, glyph->x2);
+      rectangle.y1 = MIN(rectangle.y1, glyph->y1);
+      rectangle.y2 = MAX(rectangle.y2, glyph->y2);
+    }
+  }
+
+  return open == false || func(&rectangle, data);
+}
+
+static bool append_rectangle(const zathura_rectangle_t* rectangle, void* data) {
+  zathura_rectangle_t* copy = g_try_malloc(sizeof(zathura_rectangle_t));
+  if (copy == NULL) {
+    return false;
+  }
+
+  *copy = *rectangle;
+  girara_list_append(data, copy);
+  return true;
+}
+
+static bool append_match_rectangles(girara_list_t* list, pdf_text_t* text, guint start, guint end) {
+  return foreach_match_line(text, start, end, append_rectangle, list);
+}
+
+static girara_list_t* search_text_layout(pdf_text_t* page_text, const gunichar* needle, guint needle_length,
+                                         zathura_error_t* error) {
+  girara_list_t* list = girara_list_new_with_free(g_free);
+  if (list == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+    return NULL;
+  }
+
+  for (guint offset = 0; needle_length > 0 && offset < page_text->length; ++offset) {
+    const guint length = match_at(page_text, offset, needle, needle_length);
+    if (length == 0) {
+      continue;
+    }
+
+    if (append_match_rectangles(list, page_text, offset, offset + length) == false) {
+      zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+      girara_list_free(list);
+      return NULL;
+    }
+    offset += length - 1;
+  }
+
+  if (girara_list_size(list) == 0) {
+    zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
+    girara_list_free(list);
+    return NULL;
+  }
+
+  return list;
 }
 
 girara_list_t* pdf_page_search_text(zathura_page_t* page, void* data, const char* text, zathura_error_t* error) {
@@ -14,51 +158,735 @@ girara_list_t* pdf_page_search_text(zathura_page_t* page, void* data, const char
     return NULL;
   }
 
-  PopplerPage* poppler_page = data;
-  GList* results            = NULL;
-  girara_list_t* list       = NULL;
+  pdf_page_t* pdf_page         = data;
+  pdf_document_t* pdf_document = zathura_document_get_data(zathura_page_get_document(page));
 
-  /* search text */
-  results = poppler_page_find_text_with_options(poppler_page, text, POPPLER_FIND_MULTILINE);
-  if (results == NULL || g_list_length(results) == 0) {
+  /* skip pages that the full-text index rules out without extracting their text */
+  if (pdf_document != NULL &&
+      pdf_fulltext_page_may_match(pdf_document->fulltext, text, zathura_page_get_index(page)) == false) {
     zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
-    goto error_free;
+    return NULL;
   }
 
-  list = girara_list_new_with_free(g_free);
-  if (list == NULL) {
+  /* search in the cached text layout, so that repeated searches do not parse the page again */
+  pdf_text_t* page_text = pdf_page_get_text_layout(pdf_page);
+  if (page_text == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
+    return NULL;
+  }
+
+  guint needle_length = 0;
+  gunichar* needle    = fold_search_text(text, &needle_length, NULL);
+  if (needle == NULL) {
     zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+    pdf_text_unref(page_text);
+    return NULL;
+  }
+
+  girara_list_t* list = search_text_layout(page_text, needle, needle_length, error);
+  g_free(needle);
+  pdf_text_unref(page_text);
+
+  return list;
+}
+
+/* Search term prepared for a page */
+typedef struct search_term_s {
+  pdf_search_flags_t flags;
+  gunichar* needle; /* Case folded characters with collapsed white space */
+  guint8* upper;    /* Whether the characters were changed by case folding */
+  guint length;     /* Number of characters */
+  GRegex* regex;    /* Compiled pattern of regular expression terms */
+  guint last_end;   /* End of the last match, the matches of a term do not overlap */
+} search_term_t;
+
+/* State of a pass over the text of a page */
+typedef struct search_pass_s {
+  pdf_text_t* text;
+  search_term_t* terms;
+  girara_list_t* list;
+  guint* offsets;    /* Text offsets of the last characters fed to the automaton */
+  guint n_offsets;   /* Size of the ring buffer of offsets */
+  guint fed;         /* Number of characters fed to the automaton */
+  guint end;         /* Text offset after the current character */
+  unsigned int term; /* Term of the match that is appended */
+} search_pass_t;
+
+/* Base character of a character with diacritics (e.g. "e" for "é"), other characters are returned unchanged */
+static gunichar strip_diacritics(gunichar c) {
+  if (c < 0x80) {
+    return c;
+  }
+
+  gunichar decomposition[G_UNICHAR_MAX_DECOMPOSITION_LENGTH];
+  const gsize length = g_unichar_fully_decompose(c, FALSE, decomposition, G_N_ELEMENTS(decomposition));
+  for (gsize n = 1; n < length; ++n) {
+    /* e.g. Hangul syllables decompose into letters */
+    if (g_unichar_ismark(decomposition[n]) == FALSE) {
+      return c;
+    }
+  }
+
+  return length > 0 ? decomposition[0] : c;
+}
+
+static bool is_word_character(pdf_text_t* text, guint offset) {
+  return offset < text->length && g_unichar_isalnum(text->characters[offset]) == TRUE;
+}
+
+/* Checks the match of a term at [start, end) of the text against the flags of the term */
+static bool verify_term_match(pdf_text_t* text, guint start, guint end, const search_term_t* term) {
+  const bool loose          = (term->flags & PDF_SEARCH_IGNORE_DIACRITICS) != 0;
+  const bool case_sensitive = (term->flags & PDF_SEARCH_CASE_SENSITIVE) != 0;
+
+  if ((term->flags & PDF_SEARCH_WHOLE_WORD) != 0 &&
+      ((start > 0 && is_word_character(text, start - 1) == true) || is_word_character(text, end) == true)) {
+    return false;
+  }
+
+  /* regular expressions have been matched against the text by GRegex, only plain terms are compared here */
+  if (term->regex != NULL) {
+    return true;
+  }
+
+  guint i = start;
+  guint j = 0;
+  while (true) {
+    if (loose == true) {
+      while (i < end && g_unichar_ismark(text->characters[i]) == TRUE) {
+        ++i;
+      }
+      while (j < term->length && g_unichar_ismark(term->needle[j]) == TRUE) {
+        ++j;
+      }
+    }
+    if (i >= end || j >= term->length) {
+      break;
+    }
+
+    if (term->needle[j] == ' ') {
+      /* white space matches any run of white space, including line breaks */
+      if (text->characters[i] != ' ') {
+        return false;
+      }
+      while (i < end && text->characters[i] == ' ') {
+        ++i;
+      }
+      ++j;
+      continue;
+    }
+
+    const gunichar c      = loose == true ? strip_diacritics(text->characters[i]) : text->characters[i];
+    const gunichar needle = loose == true ? strip_diacritics(term->needle[j]) : term->needle[j];
+    if (c != needle || (case_sensitive == true && (text->upper[i] != 0) != (term->upper[j] != 0))) {
+      return false;
+    }
+    ++i;
+    ++j;
+  }
+
+  return i >= end && j >= term->length;
+}
+
+static bool append_term_rectangle(const zathura_rectangle_t* rectangle, void* data) {
+  search_pass_t* pass       = data;
+  pdf_search_match_t* match = g_try_malloc(sizeof(pdf_search_match_t));
+  if (match == NULL) {
+    return false;
+  }
+
+  match->term      = pass->term;
+  match->rectangle = *rectangle;
+  girara_list_append(pass->list, match);
+  return true;
+}
+
+/* Adds a match of a term unless it overlaps the previous match of the term */
+static bool append_term_match(search_pass_t* pass, unsigned int id, guint start, guint end) {
+  /* combining marks belong to the preceding character */
+  while (end < pass->text->length && g_unichar_ismark(pass->text->characters[end]) == TRUE) {
+    ++end;
+  }
+
+  search_term_t* term = &pass->terms[id];
+  if (start < term->last_end || verify_term_match(pass->text, start, end, term) == false) {
+    return true;
+  }
+
+  term->last_end = end;
+  pass->term     = id;
+  return foreach_match_line(pass->text, start, end, append_term_rectangle, pass);
+}
+
+static bool on_automaton_match(guint id, guint length, void* data) {
+  search_pass_t* pass = data;
+  const guint start   = pass->offsets[(pass->fed - length) % pass->n_offsets];
+
+  return append_term_match(pass, id, start, pass->end);
+}
+
+/* Finds all plain terms in one pass. The automaton matches case folded characters without diacritics, the flags of
+ * the terms are checked for every candidate. */
+static bool search_terms_automaton(search_pass_t* pass, pdf_automaton_t* automaton) {
+  pdf_text_t* text = pass->text;
+  guint state      = pdf_automaton_start();
+
+  for (guint i = 0; i < text->length; ++i) {
+    const gunichar c = text->characters[i];
+    if ((c == ' ' && i > 0 && text->characters[i - 1] == ' ') || g_unichar_ismark(c) == TRUE) {
+      continue;
+    }
+
+    pass->offsets[pass->fed % pass->n_offsets] = i;
+    pass->fed++;
+    pass->end = i + 1;
+
+    state = pdf_automaton_next(automaton, state, strip_diacritics(c));
+    if (pdf_automaton_foreach_match(automaton, state, on_automaton_match, pass) == false) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* Returns the index of the subject character that starts at the given byte */
+static guint subject_character(GArray* starts, gint byte) {
+  guint low  = 0;
+  guint high = starts->len;
+  while (low < high) {
+    const guint middle = low + (high - low) / 2;
+    if (g_array_index(starts, gint, middle) < byte) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  return low;
+}
+
+static bool search_term_regex(search_pass_t* pass, unsigned int id) {
+  pdf_text_t* text    = pass->text;
+  search_term_t* term = &pass->terms[id];
+  const bool loose    = (term->flags & PDF_SEARCH_IGNORE_DIACRITICS) != 0;
+
+  /* the subject is rebuilt from the cached text, positions maps its characters back to text offsets */
+  GString* subject  = g_string_sized_new(text->length);
+  GArray* starts    = g_array_sized_new(FALSE, FALSE, sizeof(gint), text->length + 1);
+  GArray* positions = g_array_sized_new(FALSE, FALSE, sizeof(guint), text->length);
+  for (guint i = 0; i < text->length; ++i) {
+    gunichar c = text->characters[i];
+    if (loose == true) {
+      if (g_unichar_ismark(c) == TRUE) {
+        continue;
+      }
+      c = strip_diacritics(c);
+    }
+    if ((term->flags & PDF_SEARCH_CASE_SENSITIVE) != 0 && text->upper[i] != 0) {
+      c = g_unichar_toupper(c);
+    }
+
+    const gint start = subject->len;
+    g_array_append_val(starts, start);
+    g_array_append_val(positions, i);
+    g_string_append_unichar(subject, c);
+  }
+  const gint length = subject->len;
+  g_array_append_val(starts, length);
+
+  bool ret               = true;
+  GMatchInfo* match_info = NULL;
+  g_regex_match(term->regex, subject->str, 0, &match_info);
+  while (ret == true && g_match_info_matches(match_info) == TRUE) {
+    gint match_start = 0;
+    gint match_end   = 0;
+    g_match_info_fetch_pos(match_info, 0, &match_start, &match_end);
+
+    if (match_end > match_start) {
+      const guint first = subject_character(starts, match_start);
+      const guint last  = subject_character(starts, match_end);
+      ret               = append_term_match(pass, id, g_array_index(positions, guint, first),
+                                            g_array_index(positions, guint, last - 1) + 1);
+    }
+    g_match_info_next(match_info, NULL);
+  }
+
+  g_match_info_free(match_info);
+  g_array_unref(positions);
+  g_array_unref(starts);
+  g_string_free(subject, TRUE);
+
+  return ret;
+}
+
+static void search_terms_clear(search_term_t* terms, unsigned int n_terms) {
+  for (unsigned int n = 0; n < n_terms; ++n) {
+    g_free(terms[n].needle);
+    g_free(terms[n].upper);
+    if (terms[n].regex != NULL) {
+      g_regex_unref(terms[n].regex);
+    }
+  }
+  g_free(terms);
+}
+
+/* Skips pages that the full-text index rules out for all terms. Regular expressions and diacritics insensitive
+ * terms cannot be checked against the index. */
+static bool search_terms_may_match(pdf_document_t* pdf_document, const pdf_search_term_t* terms,
+                                   unsigned int n_terms, unsigned int page) {
+  if (pdf_document == NULL) {
+    return true;
+  }
+
+  for (unsigned int n = 0; n < n_terms; ++n) {
+    if ((terms[n].flags & (PDF_SEARCH_REGEX | PDF_SEARCH_IGNORE_DIACRITICS)) != 0 ||
+        pdf_fulltext_page_may_match(pdf_document->fulltext, terms[n].text, page) == true) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+girara_list_t* pdf_page_search_terms(zathura_page_t* page, void* data, const pdf_search_term_t* terms,
+                                     unsigned int n_terms, zathura_error_t* error) {
+  if (page == NULL || data == NULL || terms == NULL || n_terms == 0) {
+    zathura_check_set_error(error, ZATHURA_ERROR_INVALID_ARGUMENTS);
+    return NULL;
+  }
+
+  for (unsigned int n = 0; n < n_terms; ++n) {
+    if (terms[n].text == NULL || strlen(terms[n].text) == 0) {
+      zathura_check_set_error(error, ZATHURA_ERROR_INVALID_ARGUMENTS);
+      return NULL;
+    }
+  }
+
+  pdf_page_t* pdf_page = data;
+  if (search_terms_may_match(pdf_page->document, terms, n_terms, pdf_page->index) == false) {
+    zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
+    return NULL;
+  }
+
+  pdf_text_t* page_text = pdf_page_get_text_layout(pdf_page);
+  if (page_text == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
+    return NULL;
+  }
+
+  zathura_error_t ret        = ZATHURA_ERROR_OK;
+  search_term_t* prepared    = g_try_malloc0_n(n_terms, sizeof(search_term_t));
+  pdf_automaton_t* automaton = pdf_automaton_new();
+  girara_list_t* list        = girara_list_new_with_free(g_free);
+  search_pass_t pass         = {.text = page_text, .terms = prepared, .list = list};
+  if (prepared == NULL || automaton == NULL || list == NULL) {
+    ret = ZATHURA_ERROR_OUT_OF_MEMORY;
     goto error_free;
   }
 
-  const double page_height = zathura_page_get_height(page);
-  for (GList* entry = results; entry && entry->data; entry = g_list_next(entry)) {
-    PopplerRectangle* poppler_rectangle = (PopplerRectangle*)entry->data;
-    zathura_rectangle_t* rectangle      = g_try_malloc0(sizeof(zathura_rectangle_t));
-    if (rectangle == NULL) {
-      zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+  bool plain = false;
+  for (unsigned int n = 0; n < n_terms; ++n) {
+    search_term_t* term = &prepared[n];
+    term->flags         = terms[n].flags;
+
+    if ((term->flags & PDF_SEARCH_REGEX) != 0) {
+      const GRegexCompileFlags flags =
+          G_REGEX_OPTIMIZE | ((term->flags & PDF_SEARCH_CASE_SENSITIVE) != 0 ? 0 : G_REGEX_CASELESS);
+      term->regex = g_regex_new(terms[n].text, flags, 0, NULL);
+      if (term->regex == NULL) {
+        ret = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        goto error_free;
+      }
+      continue;
+    }
+
+    term->needle = fold_search_text(terms[n].text, &term->length, &term->upper);
+    if (term->needle == NULL) {
+      ret = ZATHURA_ERROR_OUT_OF_MEMORY;
+      goto error_free;
+    }
+
+    /* the automaton sees the characters the way search_terms_automaton feeds them */
+    guint length = 0;
+    for (guint i = 0; i < term->length; ++i) {
+      if (g_unichar_ismark(term->needle[i]) == FALSE) {
+        ++length;
+      }
+    }
+    gunichar* pattern = g_try_malloc_n(length + 1, sizeof(gunichar));
+    if (pattern == NULL) {
+      ret = ZATHURA_ERROR_OUT_OF_MEMORY;
+      goto error_free;
+    }
+    length = 0;
+    for (guint i = 0; i < term->length; ++i) {
+      if (g_unichar_ismark(term->needle[i]) == FALSE) {
+        pattern[length++] = strip_diacritics(term->needle[i]);
+      }
+    }
+
+    pdf_automaton_add(automaton, pattern, length, n);
+    pass.n_offsets = MAX(pass.n_offsets, length);
+    plain          = plain == true || length > 0;
+    g_free(pattern);
+  }
+
+  if (plain == true) {
+    pdf_automaton_build(automaton);
+    pass.offsets = g_try_malloc_n(pass.n_offsets, sizeof(guint));
+    if (pass.offsets == NULL || search_terms_automaton(&pass, automaton) == false) {
+      ret = ZATHURA_ERROR_OUT_OF_MEMORY;
       goto error_free;
     }
+  }
 
-    rectangle->x1 = poppler_rectangle->x1;
-    rectangle->x2 = poppler_rectangle->x2;
-    rectangle->y1 = page_height - poppler_rectangle->y2;
-    rectangle->y2 = page_height - poppler_rectangle->y1;
+  for (unsigned int n = 0; n < n_terms; ++n) {
+    if (prepared[n].regex != NULL && search_term_regex(&pass, n) == false) {
+      ret = ZATHURA_ERROR_OUT_OF_MEMORY;
+      goto error_free;
+    }
+  }
 
-    girara_list_append(list, rectangle);
+  if (girara_list_size(list) == 0) {
+    ret = ZATHURA_ERROR_UNKNOWN;
+    goto error_free;
   }
 
-  g_list_free_full(results, rectangle_free);
+  g_free(pass.offsets);
+  pdf_automaton_free(automaton);
+  search_terms_clear(prepared, n_terms);
+  pdf_text_unref(page_text);
+
   return list;
 
 error_free:
-  if (results != NULL) {
-    g_list_free_full(results, rectangle_free);
+  zathura_check_set_error(error, ret);
+  pdf_text_unref(page_text);
+  g_free(pass.offsets);
+  pdf_automaton_free(automaton);
+  if (prepared != NULL) {
+    search_terms_clear(prepared, n_terms);
   }
-
   if (list != NULL) {
     girara_list_free(list);
   }
 
   return NULL;
 }
+
+typedef struct search_job_s {
+  zathura_document_t* document;
+  pdf_document_t* pdf_document;
+  const char* text;
+  const gunichar* needle;
+  guint needle_length;
+  unsigned int number_of_pages;
+  unsigned int first_page; /* Page searched first, the search wraps around after the last page */
+  unsigned int chunk_size;
+  gint next_chunk;
+  gint started; /* Number of workers that have tried to acquire a document (accessed atomically) */
+  gint workers; /* Number of workers that have acquired a document (accessed atomically) */
+  girara_list_t** results; /* Results in search order */
+
+  /* streaming searches */
+  GCancellable* cancellable;
+  pdf_search_callback_t callback;
+  void* callback_data;
+  gint stopped;           /* Set once the search is cancelled or stopped by the callback (accessed atomically) */
+  GMutex lock;            /* Protects done, delivered and running */
+  GCond cond;             /* Signalled when a position is searched or a worker exits */
+  bool* done;             /* Whether a position has been searched */
+  unsigned int delivered; /* Number of positions passed on to the callback */
+  unsigned int running;   /* Number of workers that have not exited yet */
+} search_job_t;
+
+static girara_list_t* search_page(search_job_t* job, PopplerDocument* poppler_document, unsigned int index) {
+  if (pdf_fulltext_page_may_match(job->pdf_document->fulltext, job->text, index) == false) {
+    return NULL;
+  }
+
+  zathura_page_t* page = zathura_document_get_page(job->document, index);
+  pdf_page_t* pdf_page = page != NULL ? zathura_page_get_data(page) : NULL;
+  if (pdf_page == NULL) {
+    return NULL;
+  }
+
+  /* a scan over the whole document would evict the layouts of the pages that are being read */
+  pdf_text_t* page_text = pdf_page_get_text_layout_from(pdf_page, poppler_document, index, false);
+  if (page_text == NULL) {
+    return NULL;
+  }
+
+  girara_list_t* list = search_text_layout(page_text, job->needle, job->needle_length, NULL);
+  pdf_text_unref(page_text);
+
+  return list;
+}
+
+/* Marks a position as searched and wakes the delivery up */
+static void search_job_complete(search_job_t* job, unsigned int position) {
+  g_mutex_lock(&job->lock);
+  job->done[position] = true;
+  g_cond_signal(&job->cond);
+  g_mutex_unlock(&job->lock);
+}
+
+/*
+ * Passes the results on to the callback in search order, as soon as all earlier positions are searched. Runs in the
+ * calling thread and calls the callback without the lock, so that the workers keep searching meanwhile and the
+ * callback never blocks a worker or its poppler document.
+ */
+static void search_job_deliver(search_job_t* job) {
+  g_mutex_lock(&job->lock);
+  while (job->delivered < job->number_of_pages && g_atomic_int_get(&job->stopped) == 0 &&
+         g_cancellable_is_cancelled(job->cancellable) == FALSE) {
+    if (job->done[job->delivered] == false) {
+      /* workers that stopped early leave their positions undone */
+      if (job->running == 0) {
+        break;
+      }
+      g_cond_wait(&job->cond, &job->lock);
+      continue;
+    }
+
+    const unsigned int current = job->delivered++;
+    girara_list_t* results     = job->results[current];
+    if (results == NULL) {
+      continue;
+    }
+    job->results[current] = NULL;
+
+    g_mutex_unlock(&job->lock);
+    const unsigned int index = (job->first_page + current) % job->number_of_pages;
+    const bool resume        = job->callback(index, results, job->callback_data);
+    g_mutex_lock(&job->lock);
+
+    if (resume == false) {
+      g_atomic_int_set(&job->stopped, 1);
+    }
+  }
+  g_mutex_unlock(&job->lock);
+}
+
+static void search_chunks(search_job_t* job, PopplerDocument* poppler_document) {
+  while (g_atomic_int_get(&job->stopped) == 0) {
+    const unsigned int first = (unsigned int)g_atomic_int_add(&job->next_chunk, 1) * job->chunk_size;
+    if (first >= job->number_of_pages) {
+      break;
+    }
+
+    const unsigned int last = MIN(first + job->chunk_size, job->number_of_pages);
+    for (unsigned int position = first; position < last; ++position) {
+      if (g_cancellable_is_cancelled(job->cancellable) == TRUE) {
+        g_atomic_int_set(&job->stopped, 1);
+        break;
+      }
+
+      const unsigned int index = (job->first_page + position) % job->number_of_pages;
+      job->results[position]   = search_page(job, poppler_document, index);
+      if (job->callback != NULL) {
+        search_job_complete(job, position);
+      }
+    }
+  }
+}
+
+static gpointer search_worker(gpointer data) {
+  search_job_t* job = data;
+
+  /*
+   * Every worker owns a poppler document, they are not safe for concurrent use. Only the first worker waits for one,
+   * the others give up if none is free, e.g. while prefetching or a signature validation holds them.
+   */
+  PopplerDocument* poppler_document = NULL;
+  if (g_atomic_int_add(&job->started, 1) == 0) {
+    poppler_document = pdf_document_pool_acquire(job->pdf_document);
+  } else {
+    poppler_document = pdf_document_pool_try_acquire(job->pdf_document);
+  }
+  if (poppler_document != NULL) {
+    g_atomic_int_inc(&job->workers);
+    search_chunks(job, poppler_document);
+    pdf_document_pool_release(job->pdf_document, poppler_document);
+  }
+
+  if (job->callback != NULL) {
+    g_mutex_lock(&job->lock);
+    job->running--;
+    g_cond_signal(&job->cond);
+    g_mutex_unlock(&job->lock);
+  }
+
+  return NULL;
+}
+
+/* Runs the workers until all pages are searched or the job is stopped, returns false if no worker got a document */
+static bool search_job_run(search_job_t* job) {
+  const unsigned int n_workers = MIN(pdf_document_pool_max_size(), job->number_of_pages);
+
+  /* workers that fail to start are not waited for */
+  job->running      = n_workers;
+  GThread** threads = g_new0(GThread*, n_workers);
+  for (unsigned int n = 0; n < n_workers; ++n) {
+    threads[n] = g_thread_try_new("pdf-search", search_worker, job, NULL);
+    if (threads[n] == NULL && job->callback != NULL) {
+      g_mutex_lock(&job->lock);
+      job->running--;
+      g_mutex_unlock(&job->lock);
+    }
+  }
+
+  if (job->callback != NULL) {
+    search_job_deliver(job);
+  }
+
+  for (unsigned int n = 0; n < n_workers; ++n) {
+    if (threads[n] != NULL) {
+      g_thread_join(threads[n]);
+    }
+  }
+  g_free(threads);
+
+  return g_atomic_int_get(&job->workers) != 0;
+}
+
+static void search_result_free(void* data) {
+  pdf_search_result_t* result = data;
+  if (result != NULL) {
+    girara_list_free(result->rectangles);
+  }
+  g_free(result);
+}
+
+girara_list_t* pdf_document_search_text(zathura_document_t* document, void* data, const char* text,
+                                        zathura_error_t* error) {
+  if (document == NULL || data == NULL || text == NULL || strlen(text) == 0) {
+    zathura_check_set_error(error, ZATHURA_ERROR_INVALID_ARGUMENTS);
+    return NULL;
+  }
+
+  const unsigned int number_of_pages = zathura_document_get_number_of_pages(document);
+  if (number_of_pages == 0) {
+    zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
+    return NULL;
+  }
+
+  search_job_t job = {
+      .document        = document,
+      .pdf_document    = data,
+      .text            = text,
+      .number_of_pages = number_of_pages,
+  };
+
+  gunichar* needle = fold_search_text(text, &job.needle_length, NULL);
+  job.results      = g_try_malloc0_n(number_of_pages, sizeof(girara_list_t*));
+  if (needle == NULL || job.results == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+    g_free(needle);
+    g_free(job.results);
+    return NULL;
+  }
+  job.needle = needle;
+
+  /* small chunks balance the load between pages of varying complexity */
+  const unsigned int n_workers = MIN(pdf_document_pool_max_size(), number_of_pages);
+  job.chunk_size               = MAX(1, number_of_pages / (n_workers * 8));
+
+  const bool started = search_job_run(&job);
+  g_free(needle);
+
+  if (started == false) {
+    zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
+    g_free(job.results);
+    return NULL;
+  }
+
+  /* merge results in page order */
+  girara_list_t* list = girara_list_new_with_free(search_result_free);
+  for (unsigned int index = 0; index < number_of_pages; ++index) {
+    if (job.results[index] == NULL) {
+      continue;
+    }
+
+    pdf_search_result_t* result = g_try_malloc0(sizeof(pdf_search_result_t));
+    if (list == NULL || result == NULL) {
+      girara_list_free(job.results[index]);
+      continue;
+    }
+
+    result->page       = index;
+    result->rectangles = job.results[index];
+    girara_list_append(list, result);
+  }
+  g_free(job.results);
+
+  if (list == NULL || girara_list_size(list) == 0) {
+    zathura_check_set_error(error, list == NULL ? ZATHURA_ERROR_OUT_OF_MEMORY : ZATHURA_ERROR_UNKNOWN);
+    if (list != NULL) {
+      girara_list_free(list);
+    }
+    return NULL;
+  }
+
+  return list;
+}
+
+zathura_error_t pdf_document_search_text_streaming(zathura_document_t* document, void* data, const char* text,
+                                                   unsigned int first_page, GCancellable* cancellable,
+                                                   pdf_search_callback_t callback, void* callback_data) {
+  if (document == NULL || data == NULL || text == NULL || strlen(text) == 0 || callback == NULL) {
+    return ZATHURA_ERROR_INVALID_ARGUMENTS;
+  }
+
+  const unsigned int number_of_pages = zathura_document_get_number_of_pages(document);
+  if (number_of_pages == 0 || first_page >= number_of_pages) {
+    return ZATHURA_ERROR_INVALID_ARGUMENTS;
+  }
+
+  /* single pages keep the workers close to the first page, so that its matches are delivered early */
+  search_job_t job = {
+      .document        = document,
+      .pdf_document    = data,
+      .text            = text,
+      .number_of_pages = number_of_pages,
+      .first_page      = first_page,
+      .chunk_size      = 1,
+      .cancellable     = cancellable,
+      .callback        = callback,
+      .callback_data   = callback_data,
+  };
+
+  zathura_error_t error = ZATHURA_ERROR_OK;
+  gunichar* needle      = fold_search_text(text, &job.needle_length, NULL);
+  job.results           = g_try_malloc0_n(number_of_pages, sizeof(girara_list_t*));
+  job.done              = g_try_malloc0_n(number_of_pages, sizeof(bool));
+  if (needle == NULL || job.results == NULL || job.done == NULL) {
+    error = ZATHURA_ERROR_OUT_OF_MEMORY;
+    goto error_free;
+  }
+  job.needle = needle;
+  g_mutex_init(&job.lock);
+  g_cond_init(&job.cond);
+
+  /* a cancelled search is reported like a failed one, the caller knows its cancellable */
+  if (search_job_run(&job) == false || g_cancellable_is_cancelled(cancellable) == TRUE) {
+    error = ZATHURA_ERROR_UNKNOWN;
+  }
+  g_cond_clear(&job.cond);
+  g_mutex_clear(&job.lock);
+
+  /* results after a cancellation or a stop are never delivered */
+  for (unsigned int position = 0; position < number_of_pages; ++position) {
+    if (job.results[position] != NULL) {
+      girara_list_free(job.results[position]);
+    }
+  }
+
+error_free:
+  g_free(needle);
+  g_free(job.results);
+  g_free(job.done);
+
+  return error;
+}
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: Zlib */
 
 #include "plugin.h"
+#include "page.h"
 
 static PopplerRectangle poppler_rect_from_zathura(zathura_rectangle_t rectangle) {
   PopplerRectangle rect = {
@@ -19,10 +20,17 @@ char* pdf_page_get_text(zathura_page_t* page, void* data, zathura_rectangle_t re
   }
 
   PopplerRectangle rect     = poppler_rect_from_zathura(rectangle);
-  PopplerPage* poppler_page = data;
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(data);
+  if (poppler_page == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
+    return NULL;
+  }
 
   /* get selected text */
-  return poppler_page_get_selected_text(poppler_page, POPPLER_SELECTION_GLYPH, &rect);
+  char* text = poppler_page_get_selected_text(poppler_page, POPPLER_SELECTION_GLYPH, &rect);
+  g_object_unref(poppler_page);
+
+  return text;
 }
 
 girara_list_t* pdf_page_get_selection(zathura_page_t* page, void* data, zathura_rectangle_t rectangle,
@@ -33,15 +41,22 @@ girara_list_t* pdf_page_get_selection(zathura_page_t* page, void* data, zathura_
   }
 
   PopplerRectangle rect     = poppler_rect_from_zathura(rectangle);
-  PopplerPage* poppler_page = data;
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(data);
+  if (poppler_page == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_UNKNOWN);
+    return NULL;
+  }
 
   girara_list_t* list = girara_list_new_with_free(g_free);
   if (list == NULL) {
     zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+    g_object_unref(poppler_page);
     goto error_free;
   }
 
-  cairo_region_t* region   = poppler_page_get_selected_region(poppler_page, 1.0, POPPLER_SELECTION_GLYPH, &rect);
+  cairo_region_t* region = poppler_page_get_selected_region(poppler_page, 1.0, POPPLER_SELECTION_GLYPH, &rect);
+  g_object_unref(poppler_page);
+
   const int num_rectangles = cairo_region_num_rectangles(region);
   for (int n = 0; n < num_rectangles; ++n) {
     cairo_rectangle_int_t r;
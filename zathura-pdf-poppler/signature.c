@@ -1,9 +1,13 @@
 /* SPDX-License-Identifier: Zlib */
 
 #include <cairo.h>
+#include <string.h>
 #include <girara/log.h>
 
 #include "plugin.h"
+#include "page.h"
+#include "pool.h"
+#include "signature.h"
 
 #define SIGNATURE_OVERLAY_OFFSET 3
 #define SIGNATURE_OVERLAY_ADJUST .5
@@ -11,6 +15,39 @@
 #define CAIRO_LINE_OFFSET_VERTICAL 13
 #define CAIRO_LINE_OFFSET_HORIZONTAL 5
 
+/* Signature field found by the scan */
+typedef struct pdf_signature_field_s {
+  unsigned int page;               /* Page index */
+  gint id;                         /* Form field id */
+  zathura_rectangle_t position;    /* Position of the field (top-left origin) */
+  bool claimed;                    /* Whether a thread has started to validate it */
+  bool validated;                  /* Whether the validation has finished */
+  zathura_signature_state_t state; /* Validation result */
+  char* signer;                    /* Signer of a valid signature */
+  GDateTime* time;                 /* Signing time of a valid signature */
+} pdf_signature_field_t;
+
+/* Scan states of a page */
+enum {
+  PAGE_UNSCANNED = 0,
+  PAGE_SCANNING,
+  PAGE_SCANNED,
+};
+
+struct pdf_signatures_s {
+  pdf_document_t* pdf_document;
+
+  GMutex lock;
+  GCond cond;
+  bool started;
+  guint8* pages; /* scan state of every page */
+  GPtrArray* fields;
+
+  GThread* scanner;
+  GThreadPool* validators;
+  gint cancelled;
+};
+
 static void print_validation_result(PopplerSignatureInfo* sig_info) {
   static const char* const cert_status_strings[] = {
       "trusted",          // POPPLER_CERTIFICATE_TRUSTED
@@ -39,85 +76,420 @@ static void print_validation_result(PopplerSignatureInfo* sig_info) {
                cert_status_strings[cert_status]);
 }
 
+static void signature_field_free(void* data) {
+  pdf_signature_field_t* field = data;
+  if (field == NULL) {
+    return;
+  }
+
+  if (field->time != NULL) {
+    g_date_time_unref(field->time);
+  }
+  g_free(field->signer);
+  g_free(field);
+}
+
 static void signature_info_free(void* data) {
   zathura_signature_info_t* signature_info = data;
   zathura_signature_info_free(signature_info);
 }
 
-girara_list_t* pdf_page_get_signatures(zathura_page_t* page, void* data, zathura_error_t* error) {
-  if (page == NULL || data == NULL) {
-    if (error) {
-      *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+static void signature_field_set_result(pdf_signature_field_t* field, PopplerSignatureInfo* sig_info) {
+  if (sig_info == NULL) {
+    field->state = ZATHURA_SIGNATURE_ERROR;
+    return;
+  }
+
+  if (girara_get_log_level() == GIRARA_DEBUG) {
+    print_validation_result(sig_info);
+  }
+
+  switch (poppler_signature_info_get_signature_status(sig_info)) {
+  case POPPLER_SIGNATURE_VALID:
+    switch (poppler_signature_info_get_certificate_status(sig_info)) {
+    case POPPLER_CERTIFICATE_TRUSTED:
+      field->signer = g_strdup(poppler_signature_info_get_signer_name(sig_info));
+      field->time   = g_date_time_ref(poppler_signature_info_get_local_signing_time(sig_info));
+      field->state  = ZATHURA_SIGNATURE_VALID;
+      break;
+    case POPPLER_CERTIFICATE_UNTRUSTED_ISSUER:
+    case POPPLER_CERTIFICATE_UNKNOWN_ISSUER:
+      field->state = ZATHURA_SIGNATURE_CERTIFICATE_UNTRUSTED;
+      break;
+    case POPPLER_CERTIFICATE_REVOKED:
+      field->state = ZATHURA_SIGNATURE_CERTIFICATE_REVOKED;
+      break;
+    case POPPLER_CERTIFICATE_EXPIRED:
+      field->state = ZATHURA_SIGNATURE_CERTIFICATE_EXPIRED;
+      break;
+    default: // CERTIFICATE NOT VERIFIED or GENERIC ERROR
+      field->state = ZATHURA_SIGNATURE_CERTIFICATE_INVALID;
+      break;
     }
-    return NULL;
+
+    break;
+  case POPPLER_SIGNATURE_GENERIC_ERROR:
+  case POPPLER_SIGNATURE_NOT_FOUND:
+  case POPPLER_SIGNATURE_NOT_VERIFIED:
+    field->state = ZATHURA_SIGNATURE_ERROR;
+    break;
+  default: // SIGNATURE INVALID or DIGEST MISMATCH or DECODING ERROR
+    field->state = ZATHURA_SIGNATURE_INVALID;
+    break;
   }
+}
+
+/* Validates a field that has been claimed by the calling thread */
+static void signature_field_validate(pdf_signatures_t* signatures, pdf_signature_field_t* field) {
+  PopplerSignatureInfo* sig_info = NULL;
 
-  girara_list_t* signatures = girara_list_new_with_free(signature_info_free);
+  /* every validator uses its own poppler document, NSS itself is thread-safe */
+  PopplerDocument* poppler_document = NULL;
+  if (g_atomic_int_get(&signatures->cancelled) == 0) {
+    poppler_document = pdf_document_pool_acquire(signatures->pdf_document);
+  }
 
-  PopplerPage* poppler_page = data;
-  const double page_height  = zathura_page_get_height(page);
-  GList* form_fields        = poppler_page_get_form_field_mapping(poppler_page);
+  if (poppler_document != NULL) {
+    PopplerFormField* form_field = poppler_document_get_form_field(poppler_document, field->id);
+    if (form_field != NULL) {
+      // get signature info (Poppler appears to have issues with performing revocation check, therefore disabled for
+      // now)
+      static const int flags = POPPLER_SIGNATURE_VALIDATION_FLAG_VALIDATE_CERTIFICATE |
+                               POPPLER_SIGNATURE_VALIDATION_FLAG_WITHOUT_OCSP_REVOCATION_CHECK |
+                               POPPLER_SIGNATURE_VALIDATION_FLAG_USE_AIA_CERTIFICATE_FETCH;
+      sig_info = poppler_form_field_signature_validate_sync(form_field, flags, NULL, NULL);
+      g_object_unref(form_field);
+    }
+    pdf_document_pool_release(signatures->pdf_document, poppler_document);
+  }
 
+  g_mutex_lock(&signatures->lock);
+  signature_field_set_result(field, sig_info);
+  field->validated = true;
+  g_cond_broadcast(&signatures->cond);
+  g_mutex_unlock(&signatures->lock);
+
+  if (sig_info != NULL) {
+    poppler_signature_info_free(sig_info);
+  }
+}
+
+static void signature_validate(gpointer data, gpointer user_data) {
+  pdf_signature_field_t* field = data;
+  pdf_signatures_t* signatures = user_data;
+
+  /* fields that a blocking request has already claimed are validated by that request */
+  g_mutex_lock(&signatures->lock);
+  const bool claimed = field->claimed;
+  field->claimed     = true;
+  g_mutex_unlock(&signatures->lock);
+
+  if (claimed == false) {
+    signature_field_validate(signatures, field);
+  }
+}
+
+static void signature_field_queue(pdf_signatures_t* signatures, pdf_signature_field_t* field) {
+  if (signatures->validators == NULL || g_thread_pool_push(signatures->validators, field, NULL) == FALSE) {
+    field->state     = ZATHURA_SIGNATURE_ERROR;
+    field->validated = true;
+  }
+}
+
+/* Finds the signature fields of a page */
+static GPtrArray* signature_scan_page(pdf_signatures_t* signatures, PopplerDocument* poppler_document,
+                                      unsigned int page) {
+  GPtrArray* fields = g_ptr_array_new();
+
+  PopplerPage* poppler_page = NULL;
+  if (poppler_document != NULL && g_atomic_int_get(&signatures->cancelled) == 0) {
+    poppler_page = poppler_document_get_page(poppler_document, page);
+  }
+  if (poppler_page == NULL) {
+    return fields;
+  }
+
+  double page_height = 0;
+  poppler_page_get_size(poppler_page, NULL, &page_height);
+
+  GList* form_fields = poppler_page_get_form_field_mapping(poppler_page);
   for (GList* entry = form_fields; entry && entry->data; entry = g_list_next(entry)) {
     PopplerFormFieldMapping* mapping = (PopplerFormFieldMapping*)entry->data;
-    PopplerFormField* form_field     = mapping->field;
-    if (poppler_form_field_get_field_type(form_field) != POPPLER_FORM_FIELD_SIGNATURE) {
+    if (poppler_form_field_get_field_type(mapping->field) != POPPLER_FORM_FIELD_SIGNATURE) {
       continue;
     }
 
-    zathura_signature_info_t* signature = zathura_signature_info_new();
-    signature->position.x1              = mapping->area.x1;
-    signature->position.x2              = mapping->area.x2;
-    signature->position.y1              = page_height - mapping->area.y2;
-    signature->position.y2              = page_height - mapping->area.y1;
-
-    // get signature info (Poppler appears to have issues with performing revocation check, therefore disabled for now)
-    static const int flags = POPPLER_SIGNATURE_VALIDATION_FLAG_VALIDATE_CERTIFICATE |
-                             POPPLER_SIGNATURE_VALIDATION_FLAG_WITHOUT_OCSP_REVOCATION_CHECK |
-                             POPPLER_SIGNATURE_VALIDATION_FLAG_USE_AIA_CERTIFICATE_FETCH;
-    PopplerSignatureInfo* sig_info = poppler_form_field_signature_validate_sync(form_field, flags, NULL, NULL);
-    if (girara_get_log_level() == GIRARA_DEBUG) {
-      print_validation_result(sig_info);
-    }
-
-    switch (poppler_signature_info_get_signature_status(sig_info)) {
-    case POPPLER_SIGNATURE_VALID:
-      switch (poppler_signature_info_get_certificate_status(sig_info)) {
-      case POPPLER_CERTIFICATE_TRUSTED:
-        signature->signer = g_strdup(poppler_signature_info_get_signer_name(sig_info));
-        signature->time   = g_date_time_ref(poppler_signature_info_get_local_signing_time(sig_info));
-        signature->state  = ZATHURA_SIGNATURE_VALID;
-        break;
-      case POPPLER_CERTIFICATE_UNTRUSTED_ISSUER:
-      case POPPLER_CERTIFICATE_UNKNOWN_ISSUER:
-        signature->state = ZATHURA_SIGNATURE_CERTIFICATE_UNTRUSTED;
-        break;
-      case POPPLER_CERTIFICATE_REVOKED:
-        signature->state = ZATHURA_SIGNATURE_CERTIFICATE_REVOKED;
-        break;
-      case POPPLER_CERTIFICATE_EXPIRED:
-        signature->state = ZATHURA_SIGNATURE_CERTIFICATE_EXPIRED;
-        break;
-      default: // CERTIFICATE NOT VERIFIED or GENERIC ERROR
-        signature->state = ZATHURA_SIGNATURE_CERTIFICATE_INVALID;
-        break;
-      }
+    pdf_signature_field_t* field = g_try_malloc0(sizeof(pdf_signature_field_t));
+    if (field == NULL) {
+      continue;
+    }
 
-      break;
-    case POPPLER_SIGNATURE_GENERIC_ERROR:
-    case POPPLER_SIGNATURE_NOT_FOUND:
-    case POPPLER_SIGNATURE_NOT_VERIFIED:
-      signature->state = ZATHURA_SIGNATURE_ERROR;
-      break;
-    default: // SIGNATURE INVALID or DIGEST MISMATCH or DECODING ERROR
-      signature->state = ZATHURA_SIGNATURE_INVALID;
+    field->page        = page;
+    field->id          = poppler_form_field_get_id(mapping->field);
+    field->position.x1 = mapping->area.x1;
+    field->position.x2 = mapping->area.x2;
+    field->position.y1 = page_height - mapping->area.y2;
+    field->position.y2 = page_height - mapping->area.y1;
+    g_ptr_array_add(fields, field);
+  }
+
+  poppler_page_free_form_field_mapping(form_fields);
+  g_object_unref(poppler_page);
+
+  return fields;
+}
+
+/*
+ * Publishes the fields of a scanned page. Fields found by the scanner are queued for the validators, fields found by
+ * a blocking request are validated by that request. Needs to be called with the lock held.
+ */
+static void signatures_publish(pdf_signatures_t* signatures, unsigned int page, GPtrArray* fields, bool queue) {
+  for (guint n = 0; n < fields->len; ++n) {
+    pdf_signature_field_t* field = g_ptr_array_index(fields, n);
+    g_ptr_array_add(signatures->fields, field);
+    if (queue == true) {
+      signature_field_queue(signatures, field);
+    }
+  }
+
+  signatures->pages[page] = PAGE_SCANNED;
+  g_cond_broadcast(&signatures->cond);
+}
+
+static gpointer signature_scan(gpointer data) {
+  pdf_signatures_t* signatures = data;
+  pdf_document_t* pdf_document = signatures->pdf_document;
+  const unsigned int n_pages   = pdf_document->number_of_pages;
+
+  for (unsigned int page = 0; page < n_pages; ++page) {
+    /* pages requested by a blocking request have been scanned by that request */
+    g_mutex_lock(&signatures->lock);
+    const bool skip = signatures->pages[page] != PAGE_UNSCANNED;
+    if (skip == false) {
+      signatures->pages[page] = PAGE_SCANNING;
+    }
+    g_mutex_unlock(&signatures->lock);
+
+    if (skip == true) {
+      continue;
+    }
+
+    /*
+     * The document is only held for one page, so that searches and blocking requests do not wait for the whole scan.
+     * Pages of a cancelled or failed scan are published without signatures so that nobody waits for them.
+     */
+    PopplerDocument* poppler_document = NULL;
+    if (g_atomic_int_get(&signatures->cancelled) == 0) {
+      poppler_document = pdf_document_pool_acquire(pdf_document);
+    }
+    GPtrArray* fields = signature_scan_page(signatures, poppler_document, page);
+    if (poppler_document != NULL) {
+      pdf_document_pool_release(pdf_document, poppler_document);
+    }
+
+    g_mutex_lock(&signatures->lock);
+    signatures_publish(signatures, page, fields, true);
+    g_mutex_unlock(&signatures->lock);
+
+    g_ptr_array_free(fields, TRUE);
+  }
+
+  return NULL;
+}
+
+/* Starts the scan on first use. Needs to be called with the lock held. */
+static void signatures_start(pdf_signatures_t* signatures) {
+  if (signatures->started == true) {
+    return;
+  }
+  signatures->started = true;
+
+  /* most documents are not signed, skip the scan for them */
+  const unsigned int n_pages = signatures->pdf_document->number_of_pages;
+  if (poppler_document_get_n_signatures(signatures->pdf_document->document) == 0) {
+    memset(signatures->pages, PAGE_SCANNED, n_pages);
+    return;
+  }
+
+  signatures->validators =
+      g_thread_pool_new(signature_validate, signatures, pdf_document_pool_max_size(), FALSE, NULL);
+  signatures->scanner = g_thread_try_new("pdf-signatures", signature_scan, signatures, NULL);
+  if (signatures->scanner == NULL) {
+    memset(signatures->pages, PAGE_SCANNED, n_pages);
+  }
+}
+
+pdf_signatures_t* pdf_signatures_new(pdf_document_t* pdf_document) {
+  pdf_signatures_t* signatures = g_try_malloc0(sizeof(pdf_signatures_t));
+  if (signatures == NULL) {
+    return NULL;
+  }
+
+  signatures->pages = g_try_malloc0(MAX(1, pdf_document->number_of_pages));
+  if (signatures->pages == NULL) {
+    g_free(signatures);
+    return NULL;
+  }
+
+  signatures->pdf_document = pdf_document;
+  signatures->fields       = g_ptr_array_new_with_free_func(signature_field_free);
+  g_mutex_init(&signatures->lock);
+  g_cond_init(&signatures->cond);
+
+  return signatures;
+}
+
+void pdf_signatures_free(pdf_signatures_t* signatures) {
+  if (signatures == NULL) {
+    return;
+  }
+
+  g_atomic_int_set(&signatures->cancelled, 1);
+  if (signatures->scanner != NULL) {
+    g_thread_join(signatures->scanner);
+  }
+  if (signatures->validators != NULL) {
+    /* running validations cannot be interrupted, queued ones are dropped */
+    g_thread_pool_free(signatures->validators, TRUE, TRUE);
+  }
+
+  g_ptr_array_unref(signatures->fields);
+  g_free(signatures->pages);
+  g_cond_clear(&signatures->cond);
+  g_mutex_clear(&signatures->lock);
+  g_free(signatures);
+}
+
+/*
+ * Scans a page that the scanner has not reached yet and validates the fields of the page that no validator has
+ * started on, so that a blocking request neither waits for the scan of the preceding pages nor for the validation of
+ * their fields. Needs to be called with the lock held, which is released meanwhile.
+ */
+static void signatures_prioritize(pdf_signatures_t* signatures, unsigned int page) {
+  if (signatures->pages[page] == PAGE_UNSCANNED) {
+    signatures->pages[page] = PAGE_SCANNING;
+    g_mutex_unlock(&signatures->lock);
+
+    PopplerDocument* poppler_document = pdf_document_pool_acquire(signatures->pdf_document);
+    GPtrArray* fields                 = signature_scan_page(signatures, poppler_document, page);
+    if (poppler_document != NULL) {
+      pdf_document_pool_release(signatures->pdf_document, poppler_document);
+    }
+
+    g_mutex_lock(&signatures->lock);
+    signatures_publish(signatures, page, fields, false);
+    g_ptr_array_free(fields, TRUE);
+  }
+
+  GPtrArray* claimed = g_ptr_array_new();
+  for (guint n = 0; n < signatures->fields->len; ++n) {
+    pdf_signature_field_t* field = g_ptr_array_index(signatures->fields, n);
+    if (field->page == page && field->claimed == false) {
+      field->claimed = true;
+      g_ptr_array_add(claimed, field);
+    }
+  }
+
+  if (claimed->len > 0) {
+    g_mutex_unlock(&signatures->lock);
+    for (guint n = 0; n < claimed->len; ++n) {
+      signature_field_validate(signatures, g_ptr_array_index(claimed, n));
+    }
+    g_mutex_lock(&signatures->lock);
+  }
+
+  g_ptr_array_free(claimed, TRUE);
+}
+
+/*
+ * Collects the validated signatures of a page. If wait is true, the page is scanned and validated ahead of the others
+ * and the call blocks until all of its signatures have been validated. Otherwise pending is set if some are not
+ * available yet.
+ */
+static girara_list_t* signatures_get(pdf_signatures_t* signatures, unsigned int page, bool wait, bool* pending) {
+  if (signatures == NULL || page >= signatures->pdf_document->number_of_pages) {
+    return NULL;
+  }
+
+  girara_list_t* list = girara_list_new_with_free(signature_info_free);
+  if (list == NULL) {
+    return NULL;
+  }
+
+  g_mutex_lock(&signatures->lock);
+  signatures_start(signatures);
+  if (wait == true) {
+    signatures_prioritize(signatures, page);
+  }
+
+  bool complete = false;
+  while (complete == false) {
+    complete = signatures->pages[page] == PAGE_SCANNED;
+    for (guint n = 0; n < signatures->fields->len && complete == true; ++n) {
+      pdf_signature_field_t* field = g_ptr_array_index(signatures->fields, n);
+      complete                     = field->page != page || field->validated == true;
+    }
+
+    if (complete == true || wait == false) {
       break;
     }
+    /* the page is being scanned or its remaining fields are being validated by other threads */
+    g_cond_wait(&signatures->cond, &signatures->lock);
+    signatures_prioritize(signatures, page);
+  }
 
-    poppler_signature_info_free(sig_info);
-    girara_list_append(signatures, signature);
+  for (guint n = 0; n < signatures->fields->len; ++n) {
+    pdf_signature_field_t* field = g_ptr_array_index(signatures->fields, n);
+    if (field->page != page || field->validated == false) {
+      continue;
+    }
+
+    zathura_signature_info_t* signature = zathura_signature_info_new();
+    signature->position                 = field->position;
+    signature->state                    = field->state;
+    signature->signer                   = g_strdup(field->signer);
+    signature->time                     = field->time != NULL ? g_date_time_ref(field->time) : NULL;
+    girara_list_append(list, signature);
+  }
+  g_mutex_unlock(&signatures->lock);
+
+  if (pending != NULL) {
+    *pending = !complete;
+  }
+
+  return list;
+}
+
+girara_list_t* pdf_page_get_signatures(zathura_page_t* page, void* data, zathura_error_t* error) {
+  if (page == NULL || data == NULL) {
+    if (error) {
+      *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+    }
+    return NULL;
+  }
+
+  /* zathura has no notion of pending signatures, so wait for the ones of this page */
+  pdf_page_t* pdf_page      = data;
+  girara_list_t* signatures = signatures_get(pdf_page->document->signatures, pdf_page->index, true, NULL);
+  if (signatures == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
+  }
+
+  return signatures;
+}
+
+girara_list_t* pdf_page_get_signatures_nonblocking(zathura_page_t* page, void* data, bool* pending,
+                                                   zathura_error_t* error) {
+  if (page == NULL || data == NULL || pending == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_INVALID_ARGUMENTS);
+    return NULL;
+  }
+
+  pdf_page_t* pdf_page      = data;
+  girara_list_t* signatures = signatures_get(pdf_page->document->signatures, pdf_page->index, false, pending);
+  if (signatures == NULL) {
+    zathura_check_set_error(error, ZATHURA_ERROR_OUT_OF_MEMORY);
   }
 
-  poppler_page_free_form_field_mapping(form_fields);
   return signatures;
 }
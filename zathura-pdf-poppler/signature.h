@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: Zlib */
+
+#ifndef SIGNATURE_H
+#define SIGNATURE_H
+
+#include "plugin.h"
+
+typedef struct pdf_signatures_s pdf_signatures_t;
+
+/**
+ * Creates the signature state of a document. Signature fields are looked up
+ * and validated in the background once signatures are first requested, and
+ * the results are kept for the lifetime of the document.
+ *
+ * @param pdf_document The document
+ * @return Signature state or NULL if an error occurred
+ */
+pdf_signatures_t* pdf_signatures_new(pdf_document_t* pdf_document);
+
+/**
+ * Stops running scans and validations and frees the signature state
+ *
+ * @param signatures The signature state
+ */
+void pdf_signatures_free(pdf_signatures_t* signatures);
+
+#endif // SIGNATURE_H
@@ -0,0 +1,227 @@
+/* SPDX-License-Identifier: Zlib */
+
+#include "page.h"
+#include "text.h"
+#include "utils.h"
+
+pdf_text_t* pdf_text_new(PopplerPage* poppler_page) {
+  if (poppler_page == NULL) {
+    return NULL;
+  }
+
+  PopplerRectangle* rectangles = NULL;
+  guint n_rectangles           = 0;
+  if (poppler_page_get_text_layout(poppler_page, &rectangles, &n_rectangles) == FALSE) {
+    n_rectangles = 0;
+  }
+
+  char* page_text = poppler_page_get_text(poppler_page);
+  if (page_text == NULL) {
+    g_free(rectangles);
+    return NULL;
+  }
+
+  pdf_text_t* text = g_try_malloc0(sizeof(pdf_text_t));
+  if (text == NULL) {
+    g_free(page_text);
+    g_free(rectangles);
+    return NULL;
+  }
+
+  /* every character of the page text has a glyph rectangle at the same offset */
+  const guint length = MIN((guint)g_utf8_strlen(page_text, -1), n_rectangles);
+  text->characters   = g_try_malloc_n(length + 1, sizeof(gunichar));
+  text->upper        = g_try_malloc_n(length + 1, sizeof(guint8));
+  text->rectangles   = g_try_malloc_n(MAX(1, length), sizeof(pdf_text_rectangle_t));
+  if (text->characters == NULL || text->upper == NULL || text->rectangles == NULL) {
+    g_free(text->characters);
+    g_free(text->upper);
+    g_free(text->rectangles);
+    g_free(page_text);
+    g_free(rectangles);
+    g_free(text);
+    return NULL;
+  }
+
+  const char* p = page_text;
+  for (guint i = 0; i < length; ++i, p = g_utf8_next_char(p)) {
+    const gunichar c    = g_utf8_get_char(p);
+    text->characters[i] = g_unichar_isspace(c) == TRUE ? ' ' : g_unichar_tolower(c);
+    text->upper[i]      = text->characters[i] != c && text->characters[i] != ' ';
+
+    text->rectangles[i].x1 = rectangles[i].x1;
+    text->rectangles[i].y1 = rectangles[i].y1;
+    text->rectangles[i].x2 = rectangles[i].x2;
+    text->rectangles[i].y2 = rectangles[i].y2;
+  }
+  text->characters[length] = 0;
+  text->upper[length]      = 0;
+  text->length             = length;
+  text->size = sizeof(pdf_text_t) + (length + 1) * (sizeof(gunichar) + sizeof(guint8)) +
+               length * sizeof(pdf_text_rectangle_t);
+  text->ref_count = 1;
+
+  g_free(page_text);
+  g_free(rectangles);
+  return text;
+}
+
+void pdf_text_unref(pdf_text_t* text) {
+  if (text == NULL || g_atomic_int_dec_and_test(&text->ref_count) == FALSE) {
+    return;
+  }
+
+  g_free(text->characters);
+  g_free(text->upper);
+  g_free(text->rectangles);
+  g_free(text);
+}
+
+static pdf_text_t* pdf_text_ref(pdf_text_t* text) {
+  if (text != NULL) {
+    g_atomic_int_inc(&text->ref_count);
+  }
+
+  return text;
+}
+
+void pdf_document_text_lru_init(pdf_document_t* pdf_document) {
+  g_queue_init(&pdf_document->text_lru.pages);
+  pdf_document->text_lru.size   = 0;
+  pdf_document->text_lru.budget = (gsize)MAX(1, pdf_getenv_uint(PDF_TEXT_CACHE_ENV, PDF_TEXT_CACHE_DEFAULT)) << 20;
+  g_mutex_init(&pdf_document->text_lru.lock);
+}
+
+void pdf_document_text_lru_clear(pdf_document_t* pdf_document) {
+  /* the pages remove themselves in pdf_page_clear */
+  g_mutex_clear(&pdf_document->text_lru.lock);
+}
+
+static void pdf_page_release_text_layout(pdf_page_t* pdf_page) {
+  g_mutex_lock(&pdf_page->lock);
+  pdf_text_t* text = pdf_page->text;
+  pdf_page->text   = NULL;
+  g_mutex_unlock(&pdf_page->lock);
+
+  pdf_text_unref(text);
+}
+
+/* Removes a page from the LRU of text layouts. Needs to be called with the LRU's lock held. */
+static void pdf_page_text_lru_unlink(pdf_page_t* pdf_page) {
+  pdf_document_t* pdf_document = pdf_page->document;
+
+  g_queue_unlink(&pdf_document->text_lru.pages, &pdf_page->text_lru_link);
+  pdf_page->text_lru_link.data = NULL;
+  pdf_document->text_lru.size -= pdf_page->text_lru_size;
+  pdf_page->text_lru_size = 0;
+}
+
+void pdf_page_clear_text_layout(pdf_page_t* pdf_page) {
+  pdf_document_t* pdf_document = pdf_page->document;
+
+  g_mutex_lock(&pdf_document->text_lru.lock);
+  if (pdf_page->text_lru_link.data != NULL) {
+    pdf_page_text_lru_unlink(pdf_page);
+  }
+  g_mutex_unlock(&pdf_document->text_lru.lock);
+
+  pdf_page_release_text_layout(pdf_page);
+}
+
+static void pdf_page_text_lru_touch(pdf_page_t* pdf_page, const pdf_text_t* text) {
+  pdf_document_t* pdf_document = pdf_page->document;
+  GQueue evicted               = G_QUEUE_INIT;
+
+  g_mutex_lock(&pdf_document->text_lru.lock);
+  if (pdf_page->text_lru_link.data != NULL) {
+    pdf_page_text_lru_unlink(pdf_page);
+  }
+  pdf_page->text_lru_link.data = pdf_page;
+  pdf_page->text_lru_size      = text->size;
+  pdf_document->text_lru.size += text->size;
+  g_queue_push_head_link(&pdf_document->text_lru.pages, &pdf_page->text_lru_link);
+
+  /* the page that was just used stays, even if its layout alone exceeds the budget */
+  while (pdf_document->text_lru.size > pdf_document->text_lru.budget && pdf_document->text_lru.pages.length > 1) {
+    pdf_page_t* page = g_queue_peek_tail(&pdf_document->text_lru.pages);
+    pdf_page_text_lru_unlink(page);
+    g_queue_push_tail(&evicted, page);
+  }
+  g_mutex_unlock(&pdf_document->text_lru.lock);
+
+  /* users of the evicted layouts keep their own references */
+  for (pdf_page_t* page = g_queue_pop_head(&evicted); page != NULL; page = g_queue_pop_head(&evicted)) {
+    pdf_page_release_text_layout(page);
+  }
+}
+
+/* Returns a new reference to the cached text layout of a page, NULL if there is none */
+static pdf_text_t* pdf_page_lookup_text_layout(pdf_page_t* pdf_page) {
+  g_mutex_lock(&pdf_page->lock);
+  pdf_text_t* text = pdf_text_ref(pdf_page->text);
+  g_mutex_unlock(&pdf_page->lock);
+
+  if (text != NULL) {
+    pdf_page_text_lru_touch(pdf_page, text);
+  }
+
+  return text;
+}
+
+static pdf_text_t* pdf_page_store_text_layout(pdf_page_t* pdf_page, pdf_text_t* text) {
+  /* another thread might have been faster */
+  g_mutex_lock(&pdf_page->lock);
+  if (pdf_page->text == NULL) {
+    pdf_page->text = text;
+  } else {
+    pdf_text_unref(text);
+  }
+  text = pdf_text_ref(pdf_page->text);
+  g_mutex_unlock(&pdf_page->lock);
+
+  pdf_page_text_lru_touch(pdf_page, text);
+  return text;
+}
+
+pdf_text_t* pdf_page_get_text_layout(pdf_page_t* pdf_page) {
+  if (pdf_page == NULL) {
+    return NULL;
+  }
+
+  pdf_text_t* text = pdf_page_lookup_text_layout(pdf_page);
+  if (text != NULL) {
+    return text;
+  }
+
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+  if (poppler_page == NULL) {
+    return NULL;
+  }
+
+  text = pdf_text_new(poppler_page);
+  g_object_unref(poppler_page);
+
+  return text != NULL ? pdf_page_store_text_layout(pdf_page, text) : NULL;
+}
+
+pdf_text_t* pdf_page_get_text_layout_from(pdf_page_t* pdf_page, PopplerDocument* poppler_document,
+                                          unsigned int index, bool store) {
+  if (pdf_page == NULL || poppler_document == NULL) {
+    return NULL;
+  }
+
+  pdf_text_t* text = pdf_page_lookup_text_layout(pdf_page);
+  if (text != NULL) {
+    return text;
+  }
+
+  PopplerPage* poppler_page = poppler_document_get_page(poppler_document, index);
+  if (poppler_page == NULL) {
+    return NULL;
+  }
+
+  text = pdf_text_new(poppler_page);
+  g_object_unref(poppler_page);
+
+  return text != NULL && store == true ? pdf_page_store_text_layout(pdf_page, text) : text;
+}
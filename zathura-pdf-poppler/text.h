@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: Zlib */
+
+#ifndef TEXT_H
+#define TEXT_H
+
+#include "plugin.h"
+
+/**
+ * Environment variable with the budget of the cached text layouts in MiB
+ */
+#define PDF_TEXT_CACHE_ENV "ZATHURA_PDF_POPPLER_TEXT_CACHE"
+
+/**
+ * Default budget of the cached text layouts in MiB. A page of dense text
+ * takes about 60 KiB, so the text of a 2000 page manual fits.
+ */
+#define PDF_TEXT_CACHE_DEFAULT 128
+
+/**
+ * Glyph rectangle of a character. Single precision is plenty for page
+ * coordinates and halves the size of the layout.
+ */
+typedef struct pdf_text_rectangle_s {
+  float x1; /**< Left edge */
+  float y1; /**< Top edge */
+  float x2; /**< Right edge */
+  float y2; /**< Bottom edge */
+} pdf_text_rectangle_t;
+
+/**
+ * Cached text layout of a page
+ */
+typedef struct pdf_text_s {
+  gunichar* characters;             /**< Case folded characters of the page text */
+  guint8* upper;                    /**< Non-zero for characters that were changed by case folding */
+  pdf_text_rectangle_t* rectangles; /**< Glyph rectangle of every character */
+  guint length;                     /**< Number of characters */
+  gsize size;                       /**< Number of bytes of the layout */
+  gint ref_count;                   /**< Reference count (accessed atomically) */
+} pdf_text_t;
+
+/**
+ * Extracts the text and the text layout of a page
+ *
+ * @param poppler_page The poppler page
+ * @return Text layout with a reference count of 1 or NULL if an error
+ *   occurred
+ */
+pdf_text_t* pdf_text_new(PopplerPage* poppler_page);
+
+/**
+ * Releases a reference to a text layout and frees it with the last one
+ *
+ * @param text The text layout (may be NULL)
+ */
+void pdf_text_unref(pdf_text_t* text);
+
+/**
+ * Initializes the LRU of cached text layouts
+ *
+ * @param pdf_document The document
+ */
+void pdf_document_text_lru_init(pdf_document_t* pdf_document);
+
+/**
+ * Clears the LRU of cached text layouts
+ *
+ * @param pdf_document The document
+ */
+void pdf_document_text_lru_clear(pdf_document_t* pdf_document);
+
+/**
+ * Removes a page from the LRU of cached text layouts and releases its layout
+ *
+ * @param pdf_page The page
+ */
+void pdf_page_clear_text_layout(pdf_page_t* pdf_page);
+
+/**
+ * Returns the cached text layout of a page and extracts it on first use. The
+ * layouts of the least recently used pages are released once all layouts
+ * take more than ZATHURA_PDF_POPPLER_TEXT_CACHE MiB, hence the caller
+ * receives its own reference and has to release it with pdf_text_unref.
+ *
+ * @param pdf_page The page
+ * @return Text layout or NULL if an error occurred
+ */
+pdf_text_t* pdf_page_get_text_layout(pdf_page_t* pdf_page);
+
+/**
+ * Returns the cached text layout of a page and extracts it from the given
+ * poppler document on first use. Used by worker threads that own a secondary
+ * poppler document. The caller has to release the layout with pdf_text_unref.
+ *
+ * @param pdf_page The page
+ * @param poppler_document The poppler document to extract the text from
+ * @param index Index of the page
+ * @param store Whether a newly extracted layout is added to the cache; scans
+ *   over the whole document pass false, so that they do not evict the layouts
+ *   of the pages that are being read
+ * @return Text layout or NULL if an error occurred
+ */
+pdf_text_t* pdf_page_get_text_layout_from(pdf_page_t* pdf_page, PopplerDocument* poppler_document,
+                                          unsigned int index, bool store);
+
+#endif // TEXT_H
@@ -0,0 +1,244 @@
+/* SPDX-License-Identifier: Zlib */
+
+#include <glib/gstdio.h>
+#include <girara/log.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "plugin.h"
+#include "trace.h"
+#include "utils.h"
+
+/* Histogram buckets: values below 2^TRACE_SUB_BITS are exact, every larger
+ * power of two is split into 2^TRACE_SUB_BITS linear buckets, which bounds the
+ * relative error to 1/16. */
+#define TRACE_SUB_BITS 4
+#define TRACE_SUB_BUCKETS (1 << TRACE_SUB_BITS)
+#define TRACE_N_BUCKETS ((64 - TRACE_SUB_BITS + 1) * TRACE_SUB_BUCKETS)
+
+static const char* const callback_names[] = {
+    "document_open",            // PDF_TRACE_DOCUMENT_OPEN
+    "document_index_generate",  // PDF_TRACE_DOCUMENT_INDEX_GENERATE
+    "document_save_as",         // PDF_TRACE_DOCUMENT_SAVE_AS
+    "document_attachments_get", // PDF_TRACE_DOCUMENT_ATTACHMENTS_GET
+    "document_attachment_save", // PDF_TRACE_DOCUMENT_ATTACHMENT_SAVE
+    "document_get_information", // PDF_TRACE_DOCUMENT_GET_INFORMATION
+    "page_init",                // PDF_TRACE_PAGE_INIT
+    "page_clear",               // PDF_TRACE_PAGE_CLEAR
+    "page_search_text",         // PDF_TRACE_PAGE_SEARCH_TEXT
+    "page_links_get",           // PDF_TRACE_PAGE_LINKS_GET
+    "page_images_get",          // PDF_TRACE_PAGE_IMAGES_GET
+    "page_get_text",            // PDF_TRACE_PAGE_GET_TEXT
+    "page_get_selection",       // PDF_TRACE_PAGE_GET_SELECTION
+    "page_render_cairo",        // PDF_TRACE_PAGE_RENDER_CAIRO
+    "page_image_get_cairo",     // PDF_TRACE_PAGE_IMAGE_GET_CAIRO
+    "page_get_label",           // PDF_TRACE_PAGE_GET_LABEL
+    "page_get_signatures",      // PDF_TRACE_PAGE_GET_SIGNATURES
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(callback_names) == PDF_TRACE_N_CALLBACKS);
+
+/* Latency histogram of a callback */
+typedef struct trace_histogram_s {
+  guint64 count;                    /* Number of calls */
+  guint64 sum;                      /* Sum of all durations */
+  guint64 max;                      /* Longest duration */
+  guint64 buckets[TRACE_N_BUCKETS]; /* Number of calls per bucket */
+} trace_histogram_t;
+
+/* Span of a single call */
+typedef struct trace_event_s {
+  pdf_trace_callback_t callback; /* Callback */
+  int page;                      /* Page index or -1 */
+  guint thread;                  /* Thread id */
+  gint64 start;                  /* Start time relative to the creation of the trace */
+  gint64 duration;               /* Duration */
+} trace_event_t;
+
+struct pdf_trace_s {
+  gint64 created; /* Creation time */
+  char* path;     /* File the events are written to (optional) */
+
+  GMutex lock;
+  trace_histogram_t histograms[PDF_TRACE_N_CALLBACKS];
+  GArray* events;
+  guint64 dropped; /* Events exceeding PDF_TRACE_MAX_EVENTS */
+};
+
+static GPrivate thread_id;
+static gint next_thread_id = 0;
+
+static guint current_thread_id(void) {
+  guint id = GPOINTER_TO_UINT(g_private_get(&thread_id));
+  if (id == 0) {
+    id = (guint)g_atomic_int_add(&next_thread_id, 1) + 1;
+    g_private_set(&thread_id, GUINT_TO_POINTER(id));
+  }
+
+  return id;
+}
+
+static unsigned int bucket_index(guint64 value) {
+  const unsigned int bits = g_bit_storage(value);
+  if (bits <= TRACE_SUB_BITS) {
+    return value;
+  }
+
+  const unsigned int shift = bits - TRACE_SUB_BITS - 1;
+  return (bits - TRACE_SUB_BITS) * TRACE_SUB_BUCKETS + ((value >> shift) & (TRACE_SUB_BUCKETS - 1));
+}
+
+static guint64 bucket_value(unsigned int index) {
+  if (index < TRACE_SUB_BUCKETS) {
+    return index;
+  }
+
+  const unsigned int shift = index / TRACE_SUB_BUCKETS - 1;
+  return (guint64)(TRACE_SUB_BUCKETS + index % TRACE_SUB_BUCKETS) << shift;
+}
+
+static guint64 histogram_percentile(const trace_histogram_t* histogram, double percentile) {
+  const guint64 rank = (guint64)(percentile * histogram->count + .5);
+  guint64 seen       = 0;
+
+  for (unsigned int n = 0; n < TRACE_N_BUCKETS; ++n) {
+    seen += histogram->buckets[n];
+    if (seen >= rank && seen > 0) {
+      return MIN(bucket_value(n), histogram->max);
+    }
+  }
+
+  return histogram->max;
+}
+
+bool pdf_trace_enabled(void) {
+  static gsize enabled = 0;
+  if (g_once_init_enter(&enabled)) {
+    g_once_init_leave(&enabled, pdf_getenv_bool(PDF_TRACE_ENV) == true ? 2 : 1);
+  }
+
+  return enabled == 2;
+}
+
+gint64 pdf_trace_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec * G_GINT64_CONSTANT(1000000000) + ts.tv_nsec;
+}
+
+pdf_trace_t* pdf_trace_new(void) {
+  if (pdf_trace_enabled() == false) {
+    return NULL;
+  }
+
+  pdf_trace_t* trace = g_try_malloc0(sizeof(pdf_trace_t));
+  if (trace == NULL) {
+    return NULL;
+  }
+
+  const char* path = g_getenv(PDF_TRACE_FILE_ENV);
+  if (path != NULL && *path != '\0') {
+    trace->path   = g_strdup(path);
+    trace->events = g_array_new(FALSE, FALSE, sizeof(trace_event_t));
+  }
+
+  trace->created = pdf_trace_now();
+  g_mutex_init(&trace->lock);
+
+  return trace;
+}
+
+void pdf_trace_record(pdf_trace_t* trace, pdf_trace_callback_t callback, int page, gint64 start) {
+  const gint64 end        = pdf_trace_now();
+  const guint64 duration  = end > start ? end - start : 0;
+  const unsigned int slot = bucket_index(duration);
+
+  g_mutex_lock(&trace->lock);
+  trace_histogram_t* histogram = &trace->histograms[callback];
+  histogram->count++;
+  histogram->sum += duration;
+  histogram->max = MAX(histogram->max, duration);
+  histogram->buckets[slot]++;
+
+  if (trace->events != NULL) {
+    if (trace->events->len < PDF_TRACE_MAX_EVENTS) {
+      trace_event_t event = {
+          .callback = callback,
+          .page     = page,
+          .thread   = current_thread_id(),
+          .start    = start - trace->created,
+          .duration = duration,
+      };
+      g_array_append_val(trace->events, event);
+    } else {
+      trace->dropped++;
+    }
+  }
+  g_mutex_unlock(&trace->lock);
+}
+
+/* Writes the events in the Chrome trace event format (timestamps in microseconds) */
+static void write_events(pdf_trace_t* trace) {
+  FILE* file = g_fopen(trace->path, "w");
+  if (file == NULL) {
+    girara_warning("Failed to write trace '%s'", trace->path);
+    return;
+  }
+
+  const int pid = getpid();
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  for (guint n = 0; n < trace->events->len; ++n) {
+    const trace_event_t* event = &g_array_index(trace->events, trace_event_t, n);
+
+    fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"pdf-poppler\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,", n > 0 ? "," : "",
+            callback_names[event->callback], pid, event->thread);
+    fprintf(file, "\"ts\":%.3f,\"dur\":%.3f", event->start / 1000.0, event->duration / 1000.0);
+    if (event->page >= 0) {
+      fprintf(file, ",\"args\":{\"page\":%d}", event->page);
+    }
+    fprintf(file, "}");
+  }
+  fprintf(file, "\n]}\n");
+
+  if (fclose(file) != 0) {
+    girara_warning("Failed to write trace '%s'", trace->path);
+  }
+}
+
+static void log_summary(pdf_trace_t* trace) {
+  girara_info("%-26s %8s %10s %10s %10s %10s %10s", "callback (ms)", "calls", "mean", "p50", "p90", "p99", "max");
+
+  for (unsigned int n = 0; n < PDF_TRACE_N_CALLBACKS; ++n) {
+    const trace_histogram_t* histogram = &trace->histograms[n];
+    if (histogram->count == 0) {
+      continue;
+    }
+
+    girara_info("%-26s %8" G_GUINT64_FORMAT " %10.3f %10.3f %10.3f %10.3f %10.3f", callback_names[n], histogram->count,
+                histogram->sum / 1e6 / histogram->count, histogram_percentile(histogram, .5) / 1e6,
+                histogram_percentile(histogram, .9) / 1e6, histogram_percentile(histogram, .99) / 1e6,
+                histogram->max / 1e6);
+  }
+
+  if (trace->dropped > 0) {
+    girara_info("%" G_GUINT64_FORMAT " trace events exceeding the limit were dropped", trace->dropped);
+  }
+}
+
+void pdf_trace_free(pdf_trace_t* trace) {
+  if (trace == NULL) {
+    return;
+  }
+
+  if (trace->events != NULL) {
+    write_events(trace);
+    g_array_unref(trace->events);
+  }
+  log_summary(trace);
+
+  g_mutex_clear(&trace->lock);
+  g_free(trace->path);
+  g_free(trace);
+}
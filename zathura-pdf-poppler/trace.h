@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: Zlib */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "plugin.h"
+
+/**
+ * Environment variable that enables the latency instrumentation of the plugin
+ * callbacks
+ */
+#define PDF_TRACE_ENV "ZATHURA_PDF_POPPLER_TRACE"
+
+/**
+ * Environment variable naming the file the trace events are written to
+ */
+#define PDF_TRACE_FILE_ENV "ZATHURA_PDF_POPPLER_TRACE_FILE"
+
+/**
+ * Maximal number of trace events kept per document
+ */
+#define PDF_TRACE_MAX_EVENTS (1 << 20)
+
+/**
+ * Instrumented plugin callbacks
+ */
+typedef enum pdf_trace_callback_e {
+  PDF_TRACE_DOCUMENT_OPEN,
+  PDF_TRACE_DOCUMENT_INDEX_GENERATE,
+  PDF_TRACE_DOCUMENT_SAVE_AS,
+  PDF_TRACE_DOCUMENT_ATTACHMENTS_GET,
+  PDF_TRACE_DOCUMENT_ATTACHMENT_SAVE,
+  PDF_TRACE_DOCUMENT_GET_INFORMATION,
+  PDF_TRACE_PAGE_INIT,
+  PDF_TRACE_PAGE_CLEAR,
+  PDF_TRACE_PAGE_SEARCH_TEXT,
+  PDF_TRACE_PAGE_LINKS_GET,
+  PDF_TRACE_PAGE_IMAGES_GET,
+  PDF_TRACE_PAGE_GET_TEXT,
+  PDF_TRACE_PAGE_GET_SELECTION,
+  PDF_TRACE_PAGE_RENDER_CAIRO,
+  PDF_TRACE_PAGE_IMAGE_GET_CAIRO,
+  PDF_TRACE_PAGE_GET_LABEL,
+  PDF_TRACE_PAGE_GET_SIGNATURES,
+  PDF_TRACE_N_CALLBACKS
+} pdf_trace_callback_t;
+
+/**
+ * Latency histograms and trace events of a document
+ */
+typedef struct pdf_trace_s pdf_trace_t;
+
+/**
+ * Returns whether the instrumentation is enabled. The environment is only
+ * read once.
+ *
+ * @return true if the callbacks are instrumented
+ */
+bool pdf_trace_enabled(void);
+
+/**
+ * Creates the instrumentation state of a document
+ *
+ * @return Instrumentation state or NULL if the instrumentation is disabled
+ */
+pdf_trace_t* pdf_trace_new(void);
+
+/**
+ * Writes the collected trace events, logs a latency summary of every
+ * callback and frees the instrumentation state
+ *
+ * @param trace Instrumentation state (may be NULL)
+ */
+void pdf_trace_free(pdf_trace_t* trace);
+
+/**
+ * Returns the current time of the clock used for the measurements
+ *
+ * @return Monotonic time in nanoseconds
+ */
+gint64 pdf_trace_now(void);
+
+/**
+ * Records a call of a callback that started at the given time and ends now.
+ * Safe to call from multiple threads.
+ *
+ * @param trace Instrumentation state
+ * @param callback The callback
+ * @param page Page index or -1 if the callback is not bound to a page
+ * @param start Start time as returned by pdf_trace_now
+ */
+void pdf_trace_record(pdf_trace_t* trace, pdf_trace_callback_t callback, int page, gint64 start);
+
+#endif // TRACE_H
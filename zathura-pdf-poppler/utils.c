@@ -2,7 +2,63 @@
 
 #include "utils.h"
 
-zathura_link_t* poppler_link_to_zathura_link(PopplerDocument* poppler_document, PopplerAction* poppler_action,
+static void dest_free(void* data) {
+  if (data != NULL) {
+    poppler_dest_free(data);
+  }
+}
+
+void pdf_document_destinations_init(pdf_document_t* pdf_document) {
+  pdf_document->destinations.named = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, dest_free);
+  g_mutex_init(&pdf_document->destinations.lock);
+}
+
+void pdf_document_destinations_clear(pdf_document_t* pdf_document) {
+  if (pdf_document->destinations.named != NULL) {
+    g_hash_table_unref(pdf_document->destinations.named);
+    pdf_document->destinations.named = NULL;
+  }
+  g_mutex_clear(&pdf_document->destinations.lock);
+}
+
+/* Resolves a named destination once per document. The returned destination is owned by the cache. */
+static PopplerDest* find_named_dest(pdf_document_t* pdf_document, const char* name) {
+  PopplerDest* destination = NULL;
+
+  g_mutex_lock(&pdf_document->destinations.lock);
+  gpointer value = NULL;
+  if (g_hash_table_lookup_extended(pdf_document->destinations.named, name, NULL, &value) == TRUE) {
+    destination = value;
+  } else {
+    destination = poppler_document_find_dest(pdf_document->document, name);
+    g_hash_table_insert(pdf_document->destinations.named, g_strdup(name), destination);
+  }
+  g_mutex_unlock(&pdf_document->destinations.lock);
+
+  return destination;
+}
+
+static double page_height(pdf_document_t* pdf_document, int page_index) {
+  if (page_index < 0 || (unsigned int)page_index >= pdf_document->number_of_pages) {
+    return 0;
+  }
+
+  /* the size of every page is known after pdf_page_init, so no page needs to be created */
+  if (pdf_document->geometry[page_index].height > 0) {
+    return pdf_document->geometry[page_index].height;
+  }
+
+  double height             = 0;
+  PopplerPage* poppler_page = poppler_document_get_page(pdf_document->document, page_index);
+  if (poppler_page != NULL) {
+    poppler_page_get_size(poppler_page, NULL, &height);
+    g_object_unref(poppler_page);
+  }
+
+  return height;
+}
+
+zathura_link_t* poppler_link_to_zathura_link(pdf_document_t* pdf_document, PopplerAction* poppler_action,
                                              zathura_rectangle_t position) {
   zathura_link_type_t type     = ZATHURA_LINK_INVALID;
   zathura_link_target_t target = {ZATHURA_LINK_DESTINATION_UNKNOWN, NULL, 0, -1, -1, -1, -1, 0};
@@ -21,15 +77,13 @@ zathura_link_t* poppler_link_to_zathura_link(PopplerDocument* poppler_document,
     type = ZATHURA_LINK_GOTO_DEST;
 
     if (poppler_action->goto_dest.dest->type == POPPLER_DEST_NAMED) {
-      poppler_destination = poppler_document_find_dest(poppler_document, poppler_destination->named_dest);
+      poppler_destination = find_named_dest(pdf_document, poppler_destination->named_dest);
       if (poppler_destination == NULL) {
         return NULL;
       }
     }
 
-    PopplerPage* poppler_page = poppler_document_get_page(poppler_document, poppler_destination->page_num - 1);
-    double height             = 0;
-    poppler_page_get_size(poppler_page, NULL, &height);
+    const double height = page_height(pdf_document, poppler_destination->page_num - 1);
 
     switch (poppler_destination->type) {
     case POPPLER_DEST_XYZ:
@@ -125,3 +179,23 @@ zathura_link_t* poppler_link_to_zathura_link(PopplerDocument* poppler_document,
 
   return zathura_link_new(type, position, target);
 }
+
+bool pdf_getenv_bool(const char* name) {
+  const char* value = g_getenv(name);
+  return value != NULL && *value != '\0' && g_strcmp0(value, "0") != 0;
+}
+
+guint64 pdf_getenv_uint(const char* name, guint64 fallback) {
+  const char* value = g_getenv(name);
+  if (value == NULL || *value == '\0') {
+    return fallback;
+  }
+
+  char* end            = NULL;
+  const guint64 result = g_ascii_strtoull(value, &end, 10);
+  if (end == NULL || *end != '\0') {
+    return fallback;
+  }
+
+  return result;
+}
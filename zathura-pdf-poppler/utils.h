@@ -6,15 +6,47 @@
 #include "plugin.h"
 
 /**
- * Convert a poppler link object to a zathura link object
+ * Convert a poppler link object to a zathura link object. Named destinations
+ * and target page sizes are resolved through the document's caches.
  *
- * @param poppler_document The poppler document
+ * @param pdf_document The document
  * @param poppler_action The poppler action
  * @param position The position of the link
  *
  * @return Zathura link object
  */
-zathura_link_t* poppler_link_to_zathura_link(PopplerDocument* poppler_document, PopplerAction* poppler_action,
+zathura_link_t* poppler_link_to_zathura_link(pdf_document_t* pdf_document, PopplerAction* poppler_action,
                                              zathura_rectangle_t position);
 
+/**
+ * Initializes the cache of resolved named destinations
+ *
+ * @param pdf_document The document
+ */
+void pdf_document_destinations_init(pdf_document_t* pdf_document);
+
+/**
+ * Frees the cache of resolved named destinations
+ *
+ * @param pdf_document The document
+ */
+void pdf_document_destinations_clear(pdf_document_t* pdf_document);
+
+/**
+ * Reads a boolean option from the environment
+ *
+ * @param name Name of the environment variable
+ * @return true if the variable is set and not "0", otherwise false
+ */
+bool pdf_getenv_bool(const char* name);
+
+/**
+ * Reads an unsigned integer option from the environment
+ *
+ * @param name Name of the environment variable
+ * @param fallback Value used if the variable is not set or invalid
+ * @return Value of the variable
+ */
+guint64 pdf_getenv_uint(const char* name, guint64 fallback);
+
 #endif // UTILS_H